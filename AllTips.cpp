@@ -1,11 +1,17 @@
 #include "AllTips.hpp"
 
 #include "PathBundleTip.hpp"
+#include "ColorClasses.hpp"
 #include "MetagraphInterface.h"
+#include "NodeCache.hpp"
 
+#include <algorithm>
+#include <functional>
 #include <iostream>
+#include <unordered_map>
 #include <vector>
 #include <memory>
+#include <utility>
 #include <math.h>
 
 std::vector<std::vector<int>> AllTips::scoringMatrix{{5,-4,-4,-4},
@@ -13,8 +19,12 @@ std::vector<std::vector<int>> AllTips::scoringMatrix{{5,-4,-4,-4},
                                                      {-4,-4,5,-4},
                                                      {-4,-4,-4,5}};
 
+size_t AllTips::parallelFrontierSize = 1024;
+size_t AllTips::nThreads = 1;
+ThreadPool AllTips::threadPool;
+
 shared_ptr<AllTips>
-AllTips::extendAllTips(std::shared_ptr<MetagraphInterface const>  graph,
+AllTips::extendAllTips(NodeCache const & graph,
                                bool upStream,
                                size_t binsize) {
     std::vector<int> v {0,0};
@@ -22,7 +32,7 @@ AllTips::extendAllTips(std::shared_ptr<MetagraphInterface const>  graph,
 }
 
 shared_ptr<AllTips>
-AllTips::extendAllTipsWithAnalysis(std::shared_ptr<MetagraphInterface const>  graph,
+AllTips::extendAllTipsWithAnalysis(NodeCache const & graph,
                                bool upStream,
                                size_t binsize,
                                std::vector<int> & splitsAndMerge) {
@@ -30,6 +40,8 @@ AllTips::extendAllTipsWithAnalysis(std::shared_ptr<MetagraphInterface const>  gr
 
     // extend every tip and match every annotation and then merge all tips with same id
     extendWithoutUpdatingScoreWithAnalysis(newAllTips, upStream, binsize, graph, splitsAndMerge);
+    // the next frontier is fetched in the background while scores are updated and xDrop runs
+    newAllTips->prefetchNextFrontier(upStream, graph);
     newAllTips->updateScores(upStream, graph, totalScore);
 
     return newAllTips;
@@ -37,7 +49,7 @@ AllTips::extendAllTipsWithAnalysis(std::shared_ptr<MetagraphInterface const>  gr
 void AllTips::extendWithoutUpdatingScore(std::shared_ptr<AllTips> newAllTips,
                                          bool upStream,
                                          size_t binsize,
-                                         std::shared_ptr<MetagraphInterface const>  graph) const {
+                                         NodeCache const & graph) const {
     std::vector<int> v {0,0};
     extendWithoutUpdatingScoreWithAnalysis(newAllTips, upStream, binsize, graph, v);
 }
@@ -45,29 +57,29 @@ void AllTips::extendWithoutUpdatingScore(std::shared_ptr<AllTips> newAllTips,
 void AllTips::extendWithoutUpdatingScoreWithAnalysis(std::shared_ptr<AllTips> newAllTips,
                                          bool upStream,
                                          size_t binsize,
-                                         std::shared_ptr<MetagraphInterface const>  graph,
+                                         NodeCache const & graph,
                                          std::vector<int> & splitsAndMerge) const {
+    // use what was prefetched during the last step instead of fetching it twice
+    graph.waitForPrefetch();
 
-    for (auto & [id, tip] : tips) {
-        // vector<std::shared_ptr<PathBundleTip>>
-        auto const newTips = tip->extendTip(graph, upStream, binsize, numberOfExtensionsMade);
-        // at max 4
-        for (auto & newTip : newTips) {
-            // if that node is already in allNewTips -> merging the annotations
-            auto foundSameNodeID = newAllTips->tips.find(newTip->nodeID);
-            if (foundSameNodeID != newAllTips->tips.end()) {
-                unsigned tip1size = newTip->annotations.size();
-                unsigned tip2size = foundSameNodeID->second->annotations.size();
-                // merge annotations:
-                for (auto & annotation : newTip->annotations) {
-                    //TODO what if intersection of annotations of both tips is not empty?
-                    foundSameNodeID->second->annotations.insert(annotation);
+    if (isParallel(tips.size())) {
+        extendInParallel(newAllTips, upStream, binsize, graph, splitsAndMerge);
+    }
+    else {
+        for (auto & [id, tip] : tips) {
+            // vector<std::shared_ptr<PathBundleTip>>
+            auto const newTips = tip->extendTip(graph, upStream, binsize, numberOfExtensionsMade);
+            // at max 4
+            for (auto & newTip : newTips) {
+                // if that node is already in allNewTips -> merging the annotations
+                auto foundSameNodeID = newAllTips->tips.find(newTip->nodeID);
+                if (foundSameNodeID != newAllTips->tips.end()) {
+                    splitsAndMerge[1] = mergeBundles(*foundSameNodeID->second, *newTip); // merge
+                }
+                // that node isnt in allNewTips -> add it to newTips
+                else {
+                    newAllTips->tips.insert({newTip->nodeID, newTip});
                 }
-                splitsAndMerge[1] = tip1size + tip2size - foundSameNodeID->second->annotations.size(); // merge
-            }
-            // that node isnt in allNewTips -> add it to newTips
-            else {
-                newAllTips->tips.insert({newTip->nodeID, newTip});
             }
         }
     }
@@ -84,12 +96,132 @@ void AllTips::extendWithoutUpdatingScoreWithAnalysis(std::shared_ptr<AllTips> ne
     }
     newAllTips->numberOfExtensionsMade = numberOfExtensionsMade + 1;
 }
+unsigned AllTips::mergeBundles(PathBundleTip & bundle, PathBundleTip & other) {
+    unsigned tip1size = other.annotations.size();
+    unsigned tip2size = bundle.annotations.size();
+    // the bundles come from different tips, so their pending score offsets differ
+    other.materializeScores();
+    bundle.materializeScores();
+    // merge annotations:
+    for (auto & annotation : other.annotations) {
+        //TODO what if intersection of annotations of both tips is not empty?
+        bundle.annotations.insert(annotation);
+    }
+    // both gaps are up to date after materializeScores()
+    bundle.maxScoreGap = std::max(bundle.maxScoreGap, other.maxScoreGap);
+    return tip1size + tip2size - bundle.annotations.size();
+}
+// The frontier is cut into chunks, one per thread, which are extended in parallel.
+// The new bundles of a chunk are sorted into partitions by nodeID, and every partition
+// is merged by one thread, taking the bundles in the order of the frontier. Finally the
+// merged bundles are inserted in the order in which the serial loop would insert them,
+// so the result and the order of newAllTips->tips are the same as in the serial loop.
+void AllTips::extendInParallel(std::shared_ptr<AllTips> newAllTips,
+                               bool upStream,
+                               size_t binsize,
+                               NodeCache const & graph,
+                               std::vector<int> & splitsAndMerge) const {
+    // (index in frontier, index in the result of extendTip()), i.e. the order of the serial loop
+    using Position = std::pair<size_t, size_t>;
+    struct NewTip {
+        Position position;
+        std::shared_ptr<PathBundleTip> tip;
+    };
+    auto bundles = frontier();
+    size_t nPartitions = nThreads;
+    // the new bundles of every chunk, split into partitions
+    std::vector<std::vector<std::vector<NewTip>>> extended(nThreads,
+                                                           std::vector<std::vector<NewTip>>(nPartitions));
+    forEachChunk(bundles.size(), nThreads, [&](size_t chunk, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            auto const newTips = bundles[i].second->extendTip(graph, upStream, binsize, numberOfExtensionsMade);
+            for (size_t j = 0; j < newTips.size(); j++) {
+                extended[chunk][newTips[j]->nodeID % nPartitions].push_back({{i, j}, newTips[j]});
+            }
+        }
+    });
+
+    std::vector<std::vector<NewTip>> merged(nPartitions);
+    // the last merge of every partition, for splitsAndMerge
+    std::vector<std::pair<Position, int>> lastMerge(nPartitions, {{0, 0}, -1});
+    forEachChunk(nPartitions, nPartitions, [&](size_t, size_t partition, size_t) {
+        std::unordered_map<MetagraphInterface::NodeID, size_t> mergedIndex;
+        for (auto & chunk : extended) {
+            for (auto & newTip : chunk[partition]) {
+                auto foundSameNodeID = mergedIndex.find(newTip.tip->nodeID);
+                if (foundSameNodeID != mergedIndex.end()) {
+                    int nMerged = mergeBundles(*merged[partition][foundSameNodeID->second].tip, *newTip.tip);
+                    lastMerge[partition] = {newTip.position, nMerged};
+                }
+                else {
+                    mergedIndex.insert({newTip.tip->nodeID, merged[partition].size()});
+                    merged[partition].push_back(newTip);
+                }
+            }
+        }
+    });
+
+    std::vector<NewTip> newTips;
+    for (auto & partition : merged) {
+        newTips.insert(newTips.end(), partition.begin(), partition.end());
+    }
+    std::sort(newTips.begin(), newTips.end(), [](NewTip const & a, NewTip const & b) {
+        return a.position < b.position;
+    });
+    // no reserve(), the bucket count would change the order of tips
+    for (auto & newTip : newTips) {
+        newAllTips->tips.insert({newTip.tip->nodeID, newTip.tip});
+    }
+    auto last = std::max_element(lastMerge.begin(), lastMerge.end(),
+                                 [](auto const & a, auto const & b) {
+        return a.second < 0 || (b.second >= 0 && a.first < b.first);
+    });
+    if (last->second >= 0) {
+        splitsAndMerge[1] = last->second;
+    }
+}
+std::vector<std::pair<MetagraphInterface::NodeID, PathBundleTip *>> AllTips::frontier() const {
+    std::vector<std::pair<MetagraphInterface::NodeID, PathBundleTip *>> bundles;
+    bundles.reserve(tips.size());
+    for (auto & [id, tip] : tips) {
+        bundles.push_back({id, tip.get()});
+    }
+    return bundles;
+}
+void AllTips::forEachChunk(size_t n,
+                           size_t nChunks,
+                           std::function<void(size_t, size_t, size_t)> const & work) {
+    nChunks = std::max<size_t>(1, std::min(n, nChunks));
+    if (nChunks == 1) {
+        work(0, 0, n);
+        return;
+    }
+    threadPool.run(nChunks, [&](size_t chunk) {
+        work(chunk, n * chunk / nChunks, n * (chunk + 1) / nChunks);
+    });
+}
+//! the largest bundles are the most likely to be extended, so their neighbours are fetched first
+void AllTips::prefetchNextFrontier(bool upStream, NodeCache const & graph) const {
+    if (!graph.isPrefetching()) {
+        return;
+    }
+    std::vector<std::pair<size_t, MetagraphInterface::NodeID>> bundleSizes;
+    for (auto & [id, tip] : tips) {
+        bundleSizes.push_back({tip->annotations.size(), id});
+    }
+    std::sort(bundleSizes.begin(), bundleSizes.end(), std::greater<>());
+    std::vector<MetagraphInterface::NodeID> nodeIDs;
+    for (auto & [size, id] : bundleSizes) {
+        nodeIDs.push_back(id);
+    }
+    graph.prefetch(nodeIDs, upStream);
+}
 //! for the first AllTips evaluate every base of kmers corresponding to tips
-void AllTips::initScore(std::shared_ptr<MetagraphInterface const>  graph) {
-    for (unsigned i = 0; i < graph->getK(); i++) {
+void AllTips::initScore(NodeCache const & graph) {
+    for (unsigned i = 0; i < graph.getK(); i++) {
         auto acgt = nACGTatKmersPos(i, graph);
         for (auto & [id, tip] : this->tips) {
-            auto currentBase = graph->getKmer(id).at(i);
+            auto currentBase = graph.getKmer(id).at(i);
             for (auto & [anno, scoreStruct] : tip->annotations) {
                 auto score = charVsProfileScore(currentBase, acgt);
                 scoreStruct.currentScore += score;
@@ -120,29 +252,76 @@ double AllTips::charVsProfileScore(char base, std::vector<unsigned> & acgt) {
 /*! for one extension step update the score of all annos in allNewTips
 */
 void AllTips::updateScores(bool upStream,
-                           std::shared_ptr<MetagraphInterface const>  graph,
+                           NodeCache const & graph,
                            double previousTotalScore){
-    std::vector<unsigned> acgt = nACGT(upStream, graph);
+    if (isParallel(tips.size())) {
+        updateScoresInParallel(upStream, graph, previousTotalScore);
+        return;
+    }
+    // same as nACGT(), but the base of every bundle is kept for its score,
+    // so every kmer is looked up once per step
+    std::vector<char> bases;
+    bases.reserve(tips.size());
+    std::vector<unsigned> acgt{0,0,0,0};
+    for (auto & [nodeID, tip] : tips) {
+        char base = upStream ?
+                    graph.getKmer(nodeID).front() :
+                    graph.getKmer(nodeID).back();
+        bases.push_back(base);
+        acgt[AllTips::baseToId(base)] += tip->annotations.size();
+    }
     // the delta of totalScore when extending
     double deltaScore = 0;
+    size_t i = 0;
     for (auto & [nodeID, tip] : tips){
-        char currentBase = upStream ?
-                           graph->getKmer(nodeID).front() :
-                           graph->getKmer(nodeID).back();
-        for (auto & [metaAnno, annoScore] : tip->annotations) {
-            double oldScore = annoScore.currentScore;
-            double newScore = oldScore + charVsProfileScore(currentBase, acgt);
-            // to update totalScore
-            deltaScore += newScore - oldScore;
-            // set new Score
-            annoScore.currentScore = newScore;
-            // update maxScore if necessary
-            if (annoScore.maxScore <= annoScore.currentScore) {
-                annoScore.maxScore = annoScore.currentScore;
-                // set age of maxScore
-                annoScore.ageOfMaxScore = numberOfExtensionsMade;
-            }
+        char currentBase = bases[i++];
+        // every anno of the bundle gets the same score, see PathBundleTip
+        double score = charVsProfileScore(currentBase, acgt);
+        // to update totalScore
+        deltaScore += score * tip->annotations.size();
+        tip->addToScores(score);
+        // update maxScore if necessary
+        tip->updateMaxScores(numberOfExtensionsMade);
+    }
+    totalScore = previousTotalScore + deltaScore;
+}
+// same as updateScores(), the deltas of the chunks are added in the order of the chunks,
+// so totalScore can differ from the serial sum by rounding
+void AllTips::updateScoresInParallel(bool upStream,
+                                     NodeCache const & graph,
+                                     double previousTotalScore) {
+    auto bundles = frontier();
+    size_t pos = upStream ? 0 : graph.getK() - 1;
+    // the base of bundles[i], looked up once for the profile and the score
+    std::vector<char> bases(bundles.size());
+    std::vector<std::vector<unsigned>> chunkACGT(nThreads, std::vector<unsigned>{0,0,0,0});
+    forEachChunk(bundles.size(), nThreads, [&](size_t chunk, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            bases[i] = graph.getKmer(bundles[i].first).at(pos);
+            chunkACGT[chunk][AllTips::baseToId(bases[i])] += bundles[i].second->annotations.size();
+        }
+    });
+    std::vector<unsigned> acgt{0,0,0,0};
+    for (auto & counts : chunkACGT) {
+        for (unsigned b = 0; b < 4; b++) {
+            acgt[b] += counts[b];
+        }
+    }
+    std::vector<double> deltaScores(nThreads, 0);
+    forEachChunk(bundles.size(), nThreads, [&](size_t chunk, size_t begin, size_t end) {
+        // charVsProfileScore() modifies its profile temporarily
+        auto profile = acgt;
+        for (size_t i = begin; i < end; i++) {
+            auto & tip = *bundles[i].second;
+            double score = charVsProfileScore(bases[i], profile);
+            deltaScores[chunk] += score * tip.annotations.size();
+            tip.addToScores(score);
+            tip.updateMaxScores(numberOfExtensionsMade);
         }
+    });
+    double deltaScore = 0;
+    for (double chunkDeltaScore : deltaScores) {
+        deltaScore += chunkDeltaScore;
     }
     totalScore = previousTotalScore + deltaScore;
 }
@@ -150,21 +329,21 @@ void AllTips::updateScores(bool upStream,
 * of all kmers corresponding to all tips in this allNewTips
 */
 std::vector<unsigned>
-AllTips::nACGT(bool upStream, std::shared_ptr<MetagraphInterface const>  graph) const {
-    return(nACGTatKmersPos(upStream ? 0 : (graph->getK() - 1) , graph));
+AllTips::nACGT(bool upStream, NodeCache const & graph) const {
+    return(nACGTatKmersPos(upStream ? 0 : (graph.getK() - 1) , graph));
 }
 //! returns the number of each base at position pos of all kmers corresponding to all tips in this allNewTips
 std::vector<unsigned>
 AllTips::nACGTatKmersPos(unsigned pos,
-                         std::shared_ptr<MetagraphInterface const>  graph) const {
-    if (pos >= graph->getK()) {
+                         NodeCache const & graph) const {
+    if (pos >= graph.getK()) {
         std::cout << "kmer out of bounds in AllTips::nACGTatKmersPos()" << '\n';
         exit(1);
     }
     // std::cout << "nACGTatKmersPos" << '\n';
     std::vector<unsigned> acgt{0,0,0,0};
     for (auto & [nodeID, tip] : tips) {
-        char base = graph->getKmer(nodeID).at(pos);
+        char base = graph.getKmer(nodeID).at(pos);
         acgt[AllTips::baseToId(base)] += tip->annotations.size();
         // if (nodeID == 10433) std::cout << "base = " << base << ", tip->annotations.size() = " << tip->annotations.size() << '\n';
     }
@@ -181,14 +360,27 @@ size_t AllTips::nAnnotations() const {
 }
 // returns the number of unique genomes
 unsigned AllTips::nGenomes() const {
-    std::unordered_set<std::string> genomes;
+    std::unordered_set<uint32_t> genomes;
     for (auto & [id, tip] : tips) {
         for (auto & [anno, score] : tip->annotations) {
-            genomes.insert(anno.genome);
+            genomes.insert(ColorClasses::genomeIDOfTrack(anno.track));
         }
     }
     return genomes.size();
 }
+// the bundles are not shared with other AllTips (see copy ctor),
+// so the memory of all AllTips of a history can be summed up
+size_t AllTips::memoryUsage() const {
+    size_t nodeSize = sizeof(void*) + sizeof(tipsMapType::value_type) + sizeof(size_t);
+    size_t bytes = sizeof(AllTips)
+                 + tips.bucket_count() * sizeof(void*)
+                 + tips.size() * nodeSize;
+    for (auto & [id, tip] : tips) {
+        // make_shared allocates the control block next to the PathBundleTip
+        bytes += 2 * sizeof(long) + tip->memoryUsage();
+    }
+    return bytes;
+}
 // returns true, if config()->genome1() is present
 bool AllTips::containsReferenzGenome(std::shared_ptr<IdentifierMapping const> idMap) const {
     return(containsGenome(0, idMap));
@@ -196,9 +388,14 @@ bool AllTips::containsReferenzGenome(std::shared_ptr<IdentifierMapping const> id
 
 // returns true, genome with id <genomeID> is present
 bool AllTips::containsGenome(unsigned genomeID, std::shared_ptr<IdentifierMapping const> idMap) const {
+    // the ids of the idMap and of ColorClasses differ
+    return containsInternedGenome(ColorClasses::genomeID(idMap->queryGenomeName(genomeID)));
+}
+
+bool AllTips::containsInternedGenome(uint32_t internedGenomeID) const {
     for (auto & [id, tip] : tips) {
         for (auto & [anno, score] : tip->annotations) {
-            if (anno.genome == idMap->queryGenomeName(genomeID)) {
+            if (ColorClasses::genomeIDOfTrack(anno.track) == internedGenomeID) {
                 return true;
             }
         }
@@ -206,21 +403,23 @@ bool AllTips::containsGenome(unsigned genomeID, std::shared_ptr<IdentifierMappin
     return false;
 }
 
-void AllTips::printAllTips(std::shared_ptr<MetagraphInterface const> graph) const {
+void AllTips::printAllTips(NodeCache const & graph) const {
     std::cout<<"==========> printing AllTips.cpp <=========="<<std::endl;
     std::cout << "numberOfExtensionsMade: " << numberOfExtensionsMade<<std::endl;
-    auto numNodes = graph->numNodes();
+    auto numNodes = graph.numNodes();
     auto maxDecimalPlaces = std::to_string(numNodes).size();
     for (auto & [nodeID, tip] : tips) {
         auto currentDecimalPlaces = std::to_string(nodeID).size();
         int filler = maxDecimalPlaces < currentDecimalPlaces ? 0 : maxDecimalPlaces - currentDecimalPlaces;
-        for (auto & [metaAnno, annoScore] : tip->annotations) {
+        for (auto & [metaAnno, scoreWithoutOffset] : tip->annotations) {
+            auto annoScore = tip->effectiveScore(scoreWithoutOffset);
             std::cout << nodeID;
             for (int i = 0; i < filler + 1; i++) {
                 std::cout << " ";
             }
-            std::cout << "label: " << graph->getKmer(nodeID)
-                      << ",\tannotation: " << metaAnno.genome
+            auto track = ColorClasses::track(metaAnno.track);
+            std::cout << "label: " << graph.getKmer(nodeID)
+                      << ",\tannotation: " << track.genome
                       << ", cords: " << metaAnno.bin_idx << ", ";
             int filler = std::to_string(metaAnno.bin_idx).size() > 7 ? 0 : 7 - std::to_string(metaAnno.bin_idx).size();
             for (int i = 0; i < filler; i++) {
@@ -229,7 +428,7 @@ void AllTips::printAllTips(std::shared_ptr<MetagraphInterface const> graph) cons
             std::cout << "score: " << roundf(annoScore.currentScore*100)/100
                       << ",\tmaxscore: " << roundf(annoScore.maxScore*100)/100
                       << ",\tageOfMaxScore: " << annoScore.ageOfMaxScore
-                      << ",\tsequence: " <<  metaAnno.sequence
+                      << ",\tsequence: " <<  track.sequence
                       << ",\tnAnnotations(): " << nAnnotations()
                       << std::endl;
         }
@@ -241,9 +440,10 @@ void AllTips::printAllTips() const {
     std::cout<<"==========> printing AllTips.cpp <=========="<<std::endl;
     std::cout << "numberOfExtensionsMade: " << numberOfExtensionsMade<<std::endl;
     for (auto & [nodeID, tip] : tips) {
-        for (auto & [metaAnno, annoScore] : tip->annotations) {
+        for (auto & [metaAnno, scoreWithoutOffset] : tip->annotations) {
+            auto annoScore = tip->effectiveScore(scoreWithoutOffset);
             std::cout << "NodeID:\t" << nodeID
-                      << ",\tannotation: " << metaAnno.genome
+                      << ",\tannotation: " << ColorClasses::track(metaAnno.track).genome
                       << ", cords: " << metaAnno.bin_idx
                       << ",\tscore: " << roundf(annoScore.currentScore*100)/100
                       << ",\tmaxscore: " <<  roundf(annoScore.maxScore*100)/100
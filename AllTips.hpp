@@ -3,10 +3,14 @@
 
 #include "PathBundleTip.hpp"
 #include "MetagraphInterface.h"
+#include "NodeCache.hpp"
 #include "IdentifierMapping.h"
+#include "ThreadPool.hpp"
 
+#include <functional>
 #include <vector>
 #include <memory>
+#include <utility>
 
 /* ! Represents all nodes with respective bundles of annotations
 * (Erweiterungsstand)
@@ -33,11 +37,11 @@ public:
             totalScore{totalScore_},tips{tips_} {}
 
     //! extends all the PathBundleTip s
-    std::shared_ptr<AllTips> extendAllTips(std::shared_ptr<MetagraphInterface const> graph,
+    std::shared_ptr<AllTips> extendAllTips(NodeCache const & graph,
                                            bool upStream,
                                            size_t binsize);
     //! same as extendAllTips except it collects some statistics about extension
-    std::shared_ptr<AllTips> extendAllTipsWithAnalysis(std::shared_ptr<MetagraphInterface const> graph,
+    std::shared_ptr<AllTips> extendAllTipsWithAnalysis(NodeCache const & graph,
                                                        bool upStream,
                                                        size_t binsize,
                                                        std::vector<int> & splitsAndMerge);
@@ -49,36 +53,51 @@ public:
     void extendWithoutUpdatingScore(std::shared_ptr<AllTips> newAllTips,
                                     bool upStream,
                                     size_t binsize,
-                                    std::shared_ptr<MetagraphInterface const>  graph) const;
+                                    NodeCache const & graph) const;
     void extendWithoutUpdatingScoreWithAnalysis(std::shared_ptr<AllTips> newAllTips,
                                     bool upStream,
                                     size_t binsize,
-                                    std::shared_ptr<MetagraphInterface const>  graph,
+                                    NodeCache const & graph,
                                     std::vector<int> & splitsAndMerge) const;
+    //! same as the loop of extendWithoutUpdatingScoreWithAnalysis(), but with nThreads threads
+    void extendInParallel(std::shared_ptr<AllTips> newAllTips,
+                          bool upStream,
+                          size_t binsize,
+                          NodeCache const & graph,
+                          std::vector<int> & splitsAndMerge) const;
+    //! moves the annotations of other into bundle, returns the number of annotations both had
+    static unsigned mergeBundles(PathBundleTip & bundle, PathBundleTip & other);
+    //! lets graph fetch the neighbours of the PathBundleTip s in the background, largest bundles first
+    void prefetchNextFrontier(bool upStream,
+                              NodeCache const & graph) const;
     //! updates the scores of all annos and totalScore after extension without updating score
     void updateScores(bool upStream,
-                      std::shared_ptr<MetagraphInterface const>  graph,
+                      NodeCache const & graph,
                       double previousTotalScore);
+    //! same as updateScores(), but with nThreads threads
+    void updateScoresInParallel(bool upStream,
+                                NodeCache const & graph,
+                                double previousTotalScore);
 
     //TODO make this static when scoring matrix is static
     static double charVsProfileScore(char b, std::vector<unsigned> & acgt);
 
-    void initScore(std::shared_ptr<MetagraphInterface const>  graph);
+    void initScore(NodeCache const & graph);
 
     //! returns number of each base
     /*! at first or last position of all kmers corresponding to all PathBundleTip s nodeID
      * depending on extension direction
      */
     std::vector<unsigned> nACGT(bool upStream,
-                            std::shared_ptr<MetagraphInterface const>  graph) const;
+                            NodeCache const & graph) const;
 
     //! returns number of each base
     /*! at position of all kmers corresponding to all PathBundleTip s nodeID */
     std::vector<unsigned>
     nACGTatKmersPos(unsigned pos,
-                    std::shared_ptr<MetagraphInterface const>  graph) const;
+                    NodeCache const & graph) const;
 
-    void printAllTips(std::shared_ptr<MetagraphInterface const> graph) const;
+    void printAllTips(NodeCache const & graph) const;
 
     void printAllTips() const;
 
@@ -90,12 +109,17 @@ public:
 
     bool containsGenome(unsigned genomeID, std::shared_ptr<IdentifierMapping const> idMap) const;
 
+    //! returns true if genome internedGenomeID (see ColorClasses::genomeID()) is present
+    bool containsInternedGenome(uint32_t internedGenomeID) const;
+
     static unsigned baseToId(char const base);
 
     //! returns the sum of all annotations of all the PathBundleTip s of this AllTips
     size_t nAnnotations() const;
     //! returns the number of unique genomes
     unsigned nGenomes() const;
+    //! returns the number of bytes allocated for this AllTips and all its PathBundleTip s
+    size_t memoryUsage() const;
     //TODO maybe also for nGenomes and nSeq
 
     //! number of extension steps made in this direction since initFirstTip
@@ -104,8 +128,31 @@ public:
     double totalScore;
     //! all the PathBundleTips
     tipsMapType tips;
+    //! number of extension steps that were fast forwarded into this AllTips
+    /*! it stands in for that many history entries (see SeedExtension::fastForwardUnitig())
+     * not copied by the copy ctor, bc a copy is a new history entry
+     */
+    uint64_t nFastForwardedSteps = 0;
 
     static std::vector<std::vector<int>> scoringMatrix;
 
+    // parallel extension step, for seeds with large frontiers
+    //! an extension step is made with nThreads threads if there are at least this many PathBundleTip s
+    static size_t parallelFrontierSize;
+    //! number of threads of a parallel extension step, 1 (the default) disables it
+    static size_t nThreads;
+    //! returns true if a frontier of nBundles PathBundleTip s is processed in parallel
+    static bool isParallel(size_t nBundles) {
+        return nThreads > 1 && nBundles >= parallelFrontierSize;
+    }
+    //! returns the PathBundleTip s with their nodeIDs in the order of tips
+    std::vector<std::pair<MetagraphInterface::NodeID, PathBundleTip *>> frontier() const;
+    //! splits [0, n) into nChunks contiguous chunks and calls work(chunk, begin, end) for them in parallel
+    static void forEachChunk(size_t n,
+                             size_t nChunks,
+                             std::function<void(size_t, size_t, size_t)> const & work);
+    //! runs the chunks of forEachChunk()
+    static ThreadPool threadPool;
+
 };
 #endif //_ALLTIPS_HPP_
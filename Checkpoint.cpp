@@ -0,0 +1,69 @@
+#include "Checkpoint.hpp"
+
+#include "ExtensionResult.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+static std::string const headerPrefix = "#checkpoint\t";
+
+void Checkpoint::load(std::string const & header) {
+    if (outf.is_open()) {
+        return;
+    }
+    bool endsWithNewline = true;
+    std::ifstream inf(path);
+    std::string line;
+    bool isNew = !std::getline(inf, line);
+    if (!isNew && line != headerPrefix + header) {
+        std::cout << "checkpoint " << path << " is from other seeds or parameters:" << '\n'
+                  << "    " << line << '\n'
+                  << "instead of" << '\n'
+                  << "    " << headerPrefix + header << '\n';
+        exit(1);
+    }
+    endsWithNewline = !inf.eof();
+    while (std::getline(inf, line)) {
+        ExtensionResult result;
+        if (ExtensionResult::fromString(line, result)) {
+            results.insert({result.seedIndex, result});
+        }
+        endsWithNewline = !inf.eof();
+    }
+    inf.close();
+
+    outf.open(path, std::ios::app);
+    if (!outf) {
+        std::cout << "cannot open checkpoint " << path << '\n';
+        exit(1);
+    }
+    if (isNew) {
+        outf << headerPrefix << header << '\n';
+        outf.flush();
+    }
+    // terminate a line that was cut off, so that it stays invalid
+    else if (!endsWithNewline) {
+        outf << '\n';
+    }
+}
+
+void Checkpoint::add(ExtensionResult const & result) {
+    if (!outf.is_open()) {
+        std::cout << "checkpoint " << path << " is not loaded" << '\n';
+        exit(1);
+    }
+    results.insert({result.seedIndex, result});
+    outf << result.toString() << '\n';
+    nUnflushed++;
+    if (nUnflushed >= flushInterval) {
+        flush();
+    }
+}
+
+void Checkpoint::flush() {
+    if (outf.is_open()) {
+        outf.flush();
+    }
+    nUnflushed = 0;
+}
@@ -0,0 +1,60 @@
+#ifndef _Checkpoint_HPP_
+#define _Checkpoint_HPP_
+
+#include "ExtensionResult.hpp"
+
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/* Local file that records the results of all finished seeds of a batch run
+* \details Results are appended one line per seed and written to the file every
+* flushInterval seeds, so a run that was killed can be resumed with load()
+* and only the missing seeds have to be extended again.
+* A line that was cut off by a crash is ignored.
+* The first line is a header that identifies the seeds and the parameters of the
+* run (see MultiSeedExtension::checkpointHeader()), so results of another run are
+* never taken for results of this one.
+*/
+class Checkpoint {
+public:
+    Checkpoint(std::string path_, size_t flushInterval_):
+               path{path_},
+               flushInterval{flushInterval_ == 0 ? 1 : flushInterval_},
+               results{},
+               outf{},
+               nUnflushed{0} {}
+
+    ~Checkpoint() {
+        flush();
+    }
+
+    //! reads all complete results from the file and opens it for appending
+    /*! a new file starts with header. exits if the file has another header */
+    void load(std::string const & header);
+    //! returns true if the result of the seed is already in the checkpoint
+    bool isDone(size_t seedIndex) const {
+        return results.find(seedIndex) != results.end();
+    }
+    //! returns the result of a seed for which isDone() is true
+    ExtensionResult const & result(size_t seedIndex) const {
+        return results.at(seedIndex);
+    }
+    //! records the result of a finished seed, load() has to be called first
+    void add(ExtensionResult const & result);
+    //! writes all recorded results to the file
+    void flush();
+
+    std::string path;
+    //! number of seeds after which the file is flushed
+    size_t flushInterval;
+
+private:
+    //! all results, from the file and added in this run, by seed index
+    std::unordered_map<size_t, ExtensionResult> results;
+    std::ofstream outf;
+    size_t nUnflushed;
+};
+
+#endif //_Checkpoint_HPP_
@@ -0,0 +1,107 @@
+#include "ColorClasses.hpp"
+
+#include "MetagraphInterface.h"
+
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+std::mutex ColorClasses::mutex;
+ColorClasses::Table<ColorClasses::Track> ColorClasses::tracks;
+std::map<std::tuple<std::string, std::string, bool>, ColorClasses::TrackID> ColorClasses::trackIDs;
+std::unordered_map<std::string, uint32_t> ColorClasses::genomeIDs;
+ColorClasses::Table<std::vector<ColorClasses::TrackID>> ColorClasses::classes;
+std::map<std::vector<ColorClasses::TrackID>, ColorClasses::ClassID> ColorClasses::classIDs;
+
+ColorClasses::TrackID ColorClasses::trackID(MetagraphInterface::NodeAnnotation const & anno) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto key = std::make_tuple(anno.genome, anno.sequence, (bool)anno.reverse_strand);
+    auto found = trackIDs.find(key);
+    if (found != trackIDs.end()) {
+        return found->second;
+    }
+    auto genome = genomeIDs.insert({anno.genome, (uint32_t)genomeIDs.size()}).first;
+    TrackID id = tracks.push_back(Track{anno.genome, anno.sequence, (bool)anno.reverse_strand, genome->second});
+    trackIDs.insert({key, id});
+    return id;
+}
+
+ColorClasses::Track ColorClasses::track(TrackID trackID) {
+    return tracks[trackID];
+}
+
+uint32_t ColorClasses::genomeIDOfTrack(TrackID trackID) {
+    return tracks[trackID].genomeID;
+}
+
+uint32_t ColorClasses::genomeID(std::string const & genome) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return genomeIDs.insert({genome, (uint32_t)genomeIDs.size()}).first->second;
+}
+
+MetagraphInterface::NodeAnnotation ColorClasses::nodeAnnotation(AnnoKey const & anno) {
+    auto annoTrack = track(anno.track);
+    MetagraphInterface::NodeAnnotation nodeAnno;
+    nodeAnno.genome = annoTrack.genome;
+    nodeAnno.sequence = annoTrack.sequence;
+    nodeAnno.reverse_strand = annoTrack.reverse_strand;
+    nodeAnno.bin_idx = anno.bin_idx;
+    return nodeAnno;
+}
+
+ColorClasses::NodeColors
+ColorClasses::nodeColors(std::vector<MetagraphInterface::NodeAnnotation> const & annotations) {
+    NodeColors colors;
+    colors.annotations.reserve(annotations.size());
+    for (auto const & anno : annotations) {
+        colors.annotations.push_back(annoKey(anno));
+    }
+    // a track can occur in several bins of a node
+    std::vector<TrackID> classTracks;
+    for (auto const & anno : colors.annotations) {
+        classTracks.push_back(anno.track);
+    }
+    std::sort(classTracks.begin(), classTracks.end());
+    classTracks.erase(std::unique(classTracks.begin(), classTracks.end()), classTracks.end());
+    for (auto const & anno : colors.annotations) {
+        auto position = std::lower_bound(classTracks.begin(), classTracks.end(), anno.track);
+        colors.trackIndices.push_back(position - classTracks.begin());
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = classIDs.find(classTracks);
+    if (found != classIDs.end()) {
+        colors.colorClass = found->second;
+    } else {
+        colors.colorClass = classes.push_back(classTracks);
+        classIDs.insert({std::move(classTracks), colors.colorClass});
+    }
+    return colors;
+}
+
+// the cache of every thread is its own, so no lock is taken
+std::vector<bool> const & ColorClasses::sharedTracks(ClassID from, ClassID to) {
+    thread_local std::unordered_map<uint64_t, std::vector<bool>> transitions;
+    uint64_t key = ((uint64_t)from << 32) | to;
+    auto found = transitions.find(key);
+    if (found != transitions.end()) {
+        return found->second;
+    }
+    if (transitions.size() >= nCachedTransitions) {
+        transitions.clear();
+    }
+    auto const & fromTracks = classes[from];
+    auto const & toTracks = classes[to];
+    std::vector<bool> shared(toTracks.size());
+    for (size_t i = 0; i < toTracks.size(); ++i) {
+        shared[i] = std::binary_search(fromTracks.begin(), fromTracks.end(), toTracks[i]);
+    }
+    return transitions.insert({key, std::move(shared)}).first->second;
+}
+
+size_t ColorClasses::nClasses() {
+    return classes.size();
+}
@@ -0,0 +1,164 @@
+#ifndef _ColorClasses_HPP_
+#define _ColorClasses_HPP_
+
+#include "MetagraphInterface.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+/*! Interns the annotation tracks (genome, sequence, strand) and the color classes
+* (set of tracks) of the nodes.
+* \details PathBundleTip s store an annotation as AnnoKey, i.e. the id of its track
+* and its bin_idx, instead of the strings of a MetagraphInterface::NodeAnnotation.
+* Neighbouring nodes mostly have the same color class, so which tracks of a node
+* also occur in its neighbour is cached per pair of color classes (sharedTracks()).
+* A bundle still keeps one entry per annotation, bc every annotation has its own Score
+* and bin. So an extension step costs one cached class transition per edge plus up to
+* two lookups (same and neighbouring bin) per annotation of a shared track, and the
+* memory of a bundle grows with its annotations, not with the number of color classes.
+* All members are static, so every component uses the same ids. They are thread safe:
+* interning a new track or class takes a lock, reading the track or class of an id
+* does not, so the extension steps of several threads do not wait for each other.
+*/
+class ColorClasses {
+public:
+    using TrackID = uint32_t;
+    using ClassID = uint32_t;
+
+    //! one strand of one sequence of one genome
+    struct Track {
+        std::string genome;
+        std::string sequence;
+        bool reverse_strand;
+        //! interned genome, to count genomes without comparing strings
+        uint32_t genomeID;
+    };
+    //! an annotation with interned genome, sequence and strand
+    struct AnnoKey {
+        TrackID track;
+        uint64_t bin_idx;
+
+        bool operator==(AnnoKey const & other) const {
+            return track == other.track && bin_idx == other.bin_idx;
+        }
+    };
+    struct HashAnnoKey {
+        std::size_t operator()(AnnoKey const & anno) const {
+            return hashCombine(anno.track, anno.bin_idx);
+        }
+    };
+    //! returns a hash of seed and value
+    /*! std::hash of an integer is the integer itself, so a sum like bin_idx * 31 + track
+     * collides for neighbouring bins and tracks. value is mixed before it is combined
+     * with seed, and the result again, so every bit of seed and value changes about
+     * half of the bits of the hash.
+     */
+    static std::size_t hashCombine(std::size_t seed, uint64_t value) {
+        return mixBits(seed ^ mixBits(value + 0x9e3779b97f4a7c15ULL));
+    }
+    //! the finalizer of splitmix64, a bijection
+    static uint64_t mixBits(uint64_t x) {
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+    //! the annotations of a node in interned form
+    struct NodeColors {
+        ClassID colorClass;
+        std::vector<AnnoKey> annotations;
+        //! position of the track of annotations[i] in the tracks of colorClass
+        std::vector<uint32_t> trackIndices;
+    };
+
+    //! returns the id of the track of anno, a new id if the track is unknown
+    static TrackID trackID(MetagraphInterface::NodeAnnotation const & anno);
+    //! returns the interned track
+    static Track track(TrackID trackID);
+    //! returns track(trackID).genomeID without copying the strings
+    static uint32_t genomeIDOfTrack(TrackID trackID);
+    //! returns the id of genome, a new id if the genome is unknown
+    static uint32_t genomeID(std::string const & genome);
+
+    static AnnoKey annoKey(MetagraphInterface::NodeAnnotation const & anno) {
+        return AnnoKey{trackID(anno), (uint64_t)anno.bin_idx};
+    }
+    //! converts anno back to the annotation of the graph
+    static MetagraphInterface::NodeAnnotation nodeAnnotation(AnnoKey const & anno);
+
+    //! interns the annotations of a node and their color class
+    static NodeColors nodeColors(std::vector<MetagraphInterface::NodeAnnotation> const & annotations);
+    //! returns for every track of color class to, whether it is also a track of color class from
+    /*! every thread caches up to nCachedTransitions pairs and clears its cache when it is
+     * full, so the returned reference is valid until the next call of the same thread
+     */
+    static std::vector<bool> const & sharedTracks(ClassID from, ClassID to);
+    static constexpr size_t nCachedTransitions = 1 << 16;
+
+    //! number of distinct color classes seen so far
+    static size_t nClasses();
+
+private:
+    //! append-only array of the interned values, elements are read without lock and never move
+    /*! push_back() is called under mutex. A thread that reads an element got its id from
+     * the thread that added it through a lock (e.g. of the NodeCache), so the element is
+     * visible, only the chunk pointers are read while other elements are added.
+     */
+    template <typename T>
+    class Table {
+    public:
+        Table() = default;
+        ~Table() {
+            for (auto & chunk : chunks) {
+                delete[] chunk.load();
+            }
+        }
+        Table(Table const &) = delete;
+        Table & operator=(Table const &) = delete;
+
+        //! adds value and returns its index
+        size_t push_back(T value) {
+            size_t index = nElements.load(std::memory_order_relaxed);
+            if (index / chunkSize >= maxChunks) {
+                std::cout << "too many interned tracks or color classes" << '\n';
+                exit(1);
+            }
+            auto & chunk = chunks[index / chunkSize];
+            if (index % chunkSize == 0) {
+                chunk.store(new T[chunkSize], std::memory_order_release);
+            }
+            chunk.load(std::memory_order_relaxed)[index % chunkSize] = std::move(value);
+            nElements.store(index + 1, std::memory_order_release);
+            return index;
+        }
+        T const & operator[](size_t index) const {
+            return chunks[index / chunkSize].load(std::memory_order_acquire)[index % chunkSize];
+        }
+        size_t size() const {
+            return nElements.load(std::memory_order_acquire);
+        }
+
+    private:
+        static constexpr size_t chunkSize = 1 << 12;
+        static constexpr size_t maxChunks = 1 << 18;
+        std::atomic<T *> chunks[maxChunks] = {};
+        std::atomic<size_t> nElements{0};
+    };
+
+    //! guards the maps from values to ids and adding to the tables
+    static std::mutex mutex;
+    static Table<Track> tracks;
+    static std::map<std::tuple<std::string, std::string, bool>, TrackID> trackIDs;
+    static std::unordered_map<std::string, uint32_t> genomeIDs;
+    static Table<std::vector<TrackID>> classes;
+    static std::map<std::vector<TrackID>, ClassID> classIDs;
+};
+
+#endif //_ColorClasses_HPP_
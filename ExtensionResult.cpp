@@ -0,0 +1,113 @@
+#include "ExtensionResult.hpp"
+
+#include "SeedExtension.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+ExtensionResult::ExtensionResult(size_t seedIndex_, SeedExtension const & seedExtension):
+                                 seedIndex{seedIndex_},
+                                 totalScore{seedExtension.totalScore()},
+                                 maxSteps{seedExtension.maxSteps},
+                                 maxUpstreamSteps{seedExtension.maxUpstreamSteps},
+                                 nAnnotations{seedExtension.tipsHistory.back()->nAnnotations()},
+                                 nUpstreamAnnotations{seedExtension.upStreamTipsHistory.back()->nAnnotations()},
+                                 peakMemoryUsage{seedExtension.peakMemoryUsage},
+                                 memoryCapReached{seedExtension.memoryCapReached},
+                                 truncated{seedExtension.truncated},
+                                 tooManyDeletedAnnos{seedExtension.tooManyDeletedAnnos},
+                                 nMerges{seedExtension.nMerges},
+                                 nSplits{seedExtension.nSplits},
+                                 tooManyAnnosInInit{seedExtension.tooManyAnnosInInit} {}
+
+// the line ends with "end", so that a line cut off by a crash is recognized
+std::string ExtensionResult::toString() const {
+    std::ostringstream line;
+    line << seedIndex << '\t'
+         << totalScore << '\t'
+         << maxSteps << '\t'
+         << maxUpstreamSteps << '\t'
+         << nAnnotations << '\t'
+         << nUpstreamAnnotations << '\t'
+         << peakMemoryUsage << '\t'
+         << memoryCapReached << '\t'
+         << truncated << '\t'
+         << tooManyDeletedAnnos << '\t'
+         << nMerges << '\t'
+         << nSplits << '\t'
+         << tooManyAnnosInInit << '\t'
+         << "end";
+    return line.str();
+}
+
+bool ExtensionResult::fromString(std::string const & line, ExtensionResult & result) {
+    std::istringstream fields(line);
+    std::string end;
+    fields >> result.seedIndex
+           >> result.totalScore
+           >> result.maxSteps
+           >> result.maxUpstreamSteps
+           >> result.nAnnotations
+           >> result.nUpstreamAnnotations
+           >> result.peakMemoryUsage
+           >> result.memoryCapReached
+           >> result.truncated
+           >> result.tooManyDeletedAnnos
+           >> result.nMerges
+           >> result.nSplits
+           >> result.tooManyAnnosInInit
+           >> end;
+    return(!fields.fail() && end == "end");
+}
+
+bool ExtensionResult::writeAll(std::string const & path, std::vector<ExtensionResult> const & results) {
+    std::ofstream outf(path);
+    for (auto const & result : results) {
+        outf << result.toString() << '\n';
+    }
+    outf.close();
+    return(!outf.fail());
+}
+
+bool ExtensionResult::readAll(std::string const & path, std::vector<ExtensionResult> & results) {
+    std::ifstream inf(path);
+    if (!inf) {
+        std::cout << "cannot open result file " << path << '\n';
+        return false;
+    }
+    std::string line;
+    while (std::getline(inf, line)) {
+        ExtensionResult result;
+        // unlike a Checkpoint, a result file is written at once, so a broken line means a broken shard
+        if (!ExtensionResult::fromString(line, result)) {
+            std::cout << "invalid line in result file " << path << ": " << line << '\n';
+            return false;
+        }
+        results.push_back(result);
+    }
+    return true;
+}
+
+bool ExtensionResult::merge(std::vector<std::string> const & paths, std::vector<ExtensionResult> & merged) {
+    merged.clear();
+    for (auto const & path : paths) {
+        if (!readAll(path, merged)) {
+            return false;
+        }
+    }
+    std::sort(merged.begin(), merged.end(),
+              [](ExtensionResult const & a, ExtensionResult const & b) {
+        return a.seedIndex < b.seedIndex;
+    });
+    for (size_t i = 1; i < merged.size(); i++) {
+        if (merged[i - 1].seedIndex == merged[i].seedIndex) {
+            std::cout << "seed " << merged[i].seedIndex << " is in more than one result file" << '\n';
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,53 @@
+#ifndef _ExtensionResult_HPP_
+#define _ExtensionResult_HPP_
+
+#include "SeedExtension.hpp"
+
+#include <string>
+#include <vector>
+
+/* Compact summary of the extension of one seed
+* This is what is kept of a SeedExtension after the seed is finished,
+* e.g. in a Checkpoint.
+*/
+struct ExtensionResult {
+    ExtensionResult():seedIndex{0} {}
+    //! summarizes the finished extension of the seed with index seedIndex_
+    ExtensionResult(size_t seedIndex_, SeedExtension const & seedExtension);
+
+    //! one line, tab separated, without '\n'
+    std::string toString() const;
+    //! parses a line written by toString(), returns false if the line is incomplete
+    static bool fromString(std::string const & line, ExtensionResult & result);
+
+    //! writes results one per line to path, returns false if the file cannot be written
+    static bool writeAll(std::string const & path, std::vector<ExtensionResult> const & results);
+    //! appends the results in path to results, returns false if the file cannot be read or a line is invalid
+    static bool readAll(std::string const & path, std::vector<ExtensionResult> & results);
+    //! reads the result files of all shards and returns their results sorted by seedIndex
+    /*! i.e. in the order of a run in a single process
+     * returns false if a file cannot be read or a seed occurs in more than one file
+     */
+    static bool merge(std::vector<std::string> const & paths, std::vector<ExtensionResult> & merged);
+
+    size_t seedIndex;
+    int totalScore = 0;
+    int maxSteps = 0;
+    int maxUpstreamSteps = 0;
+    //! number of annotations in the last AllTips downStream
+    size_t nAnnotations = 0;
+    //! number of annotations in the last AllTips upStream
+    size_t nUpstreamAnnotations = 0;
+    size_t peakMemoryUsage = 0;
+    bool memoryCapReached = false;
+    //! true if the seed reached its budget, see SeedExtension::truncated
+    bool truncated = false;
+
+    // for extension analysis
+    int tooManyDeletedAnnos = 0;
+    int nMerges = 0;
+    int nSplits = 0;
+    int tooManyAnnosInInit = 0;
+};
+
+#endif //_ExtensionResult_HPP_
@@ -0,0 +1,208 @@
+#include "GraphTrace.hpp"
+
+#include "MetagraphInterface.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+constexpr char GraphTrace::magic[8];
+
+GraphTrace::GraphTrace(std::string const & path, size_t k, size_t numNodes, size_t capacity):outf{path, std::ios::binary} {
+    if (!outf) {
+        std::cout << "cannot open trace " << path << '\n';
+        exit(1);
+    }
+    outf.write(magic, sizeof(magic));
+    write((uint64_t)k);
+    write((uint64_t)numNodes);
+    write((uint64_t)capacity);
+}
+
+bool GraphTrace::isNew(Query query, MetagraphInterface::NodeID nodeID) {
+    if (recorded[query].insert(nodeID).second) {
+        return true;
+    }
+    write(Query::repeated);
+    write(query);
+    write((uint64_t)nodeID);
+    return false;
+}
+
+// the name record has to be written before the annotation record that uses it
+uint32_t GraphTrace::nameIndex(std::string const & name) {
+    auto found = nameIndices.insert({name, (uint32_t)nameIndices.size()});
+    if (found.second) {
+        write(Query::name);
+        writeString(name);
+    }
+    return found.first->second;
+}
+
+void GraphTrace::writeString(std::string const & str) {
+    write((uint32_t)str.size());
+    outf.write(str.data(), str.size());
+}
+
+void GraphTrace::recordNeighbours(Query query,
+                                  MetagraphInterface::NodeID nodeID,
+                                  std::vector<MetagraphInterface::NodeID> const & neighbours) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!isNew(query, nodeID)) {
+        return;
+    }
+    write(query);
+    write((uint64_t)nodeID);
+    write((uint32_t)neighbours.size());
+    for (auto neighbour : neighbours) {
+        write((uint64_t)neighbour);
+    }
+}
+
+void GraphTrace::recordAnnotation(MetagraphInterface::NodeID nodeID,
+                                  std::vector<MetagraphInterface::NodeAnnotation> const & annotations) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!isNew(Query::annotation, nodeID)) {
+        return;
+    }
+    std::vector<std::pair<uint32_t, uint32_t>> names;
+    for (auto const & anno : annotations) {
+        names.push_back({nameIndex(anno.genome), nameIndex(anno.sequence)});
+    }
+    write(Query::annotation);
+    write((uint64_t)nodeID);
+    write((uint32_t)annotations.size());
+    for (size_t i = 0; i < annotations.size(); i++) {
+        write(names[i].first);
+        write(names[i].second);
+        write((uint8_t)annotations[i].reverse_strand);
+        write((uint64_t)annotations[i].bin_idx);
+    }
+}
+
+void GraphTrace::recordKmer(MetagraphInterface::NodeID nodeID, std::string const & kmer) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!isNew(Query::kmer, nodeID)) {
+        return;
+    }
+    write(Query::kmer);
+    write((uint64_t)nodeID);
+    writeString(kmer);
+}
+
+void GraphTrace::flush() {
+    std::lock_guard<std::mutex> lock(mutex);
+    outf.flush();
+}
+
+bool GraphTrace::read(std::string const & path, Contents & contents) {
+    std::ifstream inf(path, std::ios::binary);
+    char fileMagic[sizeof(magic)];
+    uint64_t k, numNodes, capacity;
+    inf.read(fileMagic, sizeof(fileMagic));
+    inf.read(reinterpret_cast<char *>(&k), sizeof(k));
+    inf.read(reinterpret_cast<char *>(&numNodes), sizeof(numNodes));
+    inf.read(reinterpret_cast<char *>(&capacity), sizeof(capacity));
+    if (!inf || std::memcmp(fileMagic, magic, sizeof(magic)) != 0) {
+        std::cout << path << " is not a trace" << '\n';
+        return false;
+    }
+    contents.k = k;
+    contents.numNodes = numNodes;
+    contents.capacity = capacity;
+
+    auto read = [&inf](auto & value) {
+        inf.read(reinterpret_cast<char *>(&value), sizeof(value));
+        return bool(inf);
+    };
+    auto readString = [&](std::string & str) {
+        uint32_t length;
+        if (!read(length)) {
+            return false;
+        }
+        str.resize(length);
+        inf.read(&str[0], length);
+        return bool(inf);
+    };
+    std::vector<std::string> names;
+    Query query;
+    // every read fails at the end of the file, incl. a record that was cut off
+    while (read(query)) {
+        uint64_t nodeID;
+        uint32_t n;
+        if (query == Query::name) {
+            std::string name;
+            if (!readString(name)) {
+                break;
+            }
+            names.push_back(name);
+            continue;
+        }
+        if (query == Query::repeated) {
+            if (!read(query) || !read(nodeID)) {
+                break;
+            }
+            if (query >= Query::name) {
+                std::cout << "invalid record in trace " << path << '\n';
+                return false;
+            }
+            contents.queries.push_back({query, nodeID});
+            continue;
+        }
+        if (!read(nodeID)) {
+            break;
+        }
+        if (query == Query::kmer) {
+            std::string kmer;
+            if (!readString(kmer)) {
+                break;
+            }
+            contents.kmers[nodeID] = kmer;
+        }
+        else if (query == Query::outgoing || query == Query::incoming) {
+            std::vector<MetagraphInterface::NodeID> neighbours;
+            bool complete = read(n);
+            for (uint32_t i = 0; complete && i < n; i++) {
+                uint64_t neighbour;
+                complete = read(neighbour);
+                neighbours.push_back(neighbour);
+            }
+            if (!complete) {
+                break;
+            }
+            (query == Query::outgoing ? contents.outgoing : contents.incoming)[nodeID] = neighbours;
+        }
+        else if (query == Query::annotation) {
+            std::vector<MetagraphInterface::NodeAnnotation> annotations;
+            bool complete = read(n);
+            for (uint32_t i = 0; complete && i < n; i++) {
+                uint32_t genome, sequence;
+                uint8_t reverse;
+                uint64_t bin_idx;
+                complete = read(genome) && read(sequence) && read(reverse) && read(bin_idx)
+                           && genome < names.size() && sequence < names.size();
+                if (complete) {
+                    MetagraphInterface::NodeAnnotation anno;
+                    anno.genome = names[genome];
+                    anno.sequence = names[sequence];
+                    anno.reverse_strand = reverse;
+                    anno.bin_idx = bin_idx;
+                    annotations.push_back(anno);
+                }
+            }
+            if (!complete) {
+                break;
+            }
+            contents.annotations[nodeID] = annotations;
+        }
+        else {
+            std::cout << "invalid record in trace " << path << '\n';
+            return false;
+        }
+        contents.queries.push_back({query, nodeID});
+    }
+    return true;
+}
@@ -0,0 +1,90 @@
+#ifndef _GraphTrace_HPP_
+#define _GraphTrace_HPP_
+
+#include "MetagraphInterface.h"
+
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+/* Binary trace of the queries a NodeCache made to the MetagraphInterface and their responses
+* \details Recorded with NodeCache::record() during a real run. NodeCache::fromTrace()
+* serves a run from the trace instead of a graph, which allows to benchmark changes
+* of the engine on real workloads (see replayBenchmark.cpp).
+* Every query is recorded in the order it was made, i.e. every miss of the cache,
+* also when a node is fetched again after the cache was cleared. The response is
+* stored with the first query of a (query, node), later ones are repeated records.
+* So a replay can check that it makes the same queries (NodeCache::nReplayMismatches()).
+* Which nodes are fetched again depends on the capacity of the cache, so it is stored
+* with the trace and a replay uses it.
+* Genome and sequence names are stored once and referenced by index.
+*
+* Layout (native byte order):
+*   char magic[8], uint64_t k, uint64_t numNodes, uint64_t capacity
+*   records: uint8_t Query, then
+*     outgoing, incoming: uint64_t nodeID, uint32_t n, uint64_t neighbours[n]
+*     annotation:         uint64_t nodeID, uint32_t n, n * (uint32_t genome, uint32_t sequence,
+*                                                          uint8_t reverse_strand, uint64_t bin_idx)
+*     kmer:               uint64_t nodeID, uint32_t length, char kmer[length]
+*     name:               uint32_t length, char name[length], gets the next name index
+*     repeated:           uint8_t Query, uint64_t nodeID
+*/
+class GraphTrace {
+public:
+    enum Query : uint8_t {outgoing, incoming, annotation, kmer, name, repeated};
+
+    //! everything that is in a trace
+    struct Contents {
+        size_t k = 0;
+        size_t numNodes = 0;
+        //! of the NodeCache that recorded the trace
+        size_t capacity = 0;
+        std::unordered_map<MetagraphInterface::NodeID, std::vector<MetagraphInterface::NodeID>> outgoing;
+        std::unordered_map<MetagraphInterface::NodeID, std::vector<MetagraphInterface::NodeID>> incoming;
+        std::unordered_map<MetagraphInterface::NodeID, std::vector<MetagraphInterface::NodeAnnotation>> annotations;
+        std::unordered_map<MetagraphInterface::NodeID, std::string> kmers;
+        //! (query, node) of every query in the order they were made
+        std::vector<std::pair<Query, MetagraphInterface::NodeID>> queries;
+    };
+
+    //! creates the trace file at path, exits if it cannot be written
+    GraphTrace(std::string const & path, size_t k, size_t numNodes, size_t capacity);
+
+    //! the record functions are thread safe
+    void recordNeighbours(Query query,
+                          MetagraphInterface::NodeID nodeID,
+                          std::vector<MetagraphInterface::NodeID> const & neighbours);
+    void recordAnnotation(MetagraphInterface::NodeID nodeID,
+                          std::vector<MetagraphInterface::NodeAnnotation> const & annotations);
+    void recordKmer(MetagraphInterface::NodeID nodeID, std::string const & kmer);
+    //! writes the buffered records to the file
+    void flush();
+
+    //! reads the trace at path, returns false if it cannot be read
+    /*! a record that was cut off at the end of the file is ignored */
+    static bool read(std::string const & path, Contents & contents);
+
+    static constexpr char magic[8] = {'N', 'C', 'T', 'R', 'A', 'C', 'E', '3'};
+
+private:
+    //! returns true if (query, nodeID) was not recorded yet, otherwise writes a repeated record
+    bool isNew(Query query, MetagraphInterface::NodeID nodeID);
+    uint32_t nameIndex(std::string const & name);
+    template <typename T>
+    void write(T const & value) {
+        outf.write(reinterpret_cast<char const *>(&value), sizeof(value));
+    }
+    void writeString(std::string const & str);
+
+    std::ofstream outf;
+    std::mutex mutex;
+    std::unordered_set<MetagraphInterface::NodeID> recorded[4];
+    std::unordered_map<std::string, uint32_t> nameIndices;
+};
+
+#endif //_GraphTrace_HPP_
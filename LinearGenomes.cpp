@@ -0,0 +1,383 @@
+#include "LinearGenomes.hpp"
+
+#include "ColorClasses.hpp"
+#include "MetagraphInterface.h"
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+constexpr char LinearGenomes::magic[8];
+
+// returns 0 to 3 for A, C, G, T and 4 for every other character
+static unsigned baseCode(char base) {
+    switch (base) {
+        case 'A': case 'a': return 0;
+        case 'C': case 'c': return 1;
+        case 'G': case 'g': return 2;
+        case 'T': case 't': return 3;
+        default: return 4;
+    }
+}
+
+bool LinearGenomes::build(std::vector<std::pair<std::string, std::string>> const & genomeFastas,
+                          std::string const & path) {
+    std::vector<Sequence> sequences;
+    std::vector<std::string> names;
+    std::unordered_map<std::string, uint32_t> nameIndices;
+    std::vector<uint64_t> words;
+    auto nameIndex = [&](std::string const & name) {
+        auto found = nameIndices.insert({name, (uint32_t)names.size()});
+        if (found.second) {
+            names.push_back(name);
+        }
+        return found.first->second;
+    };
+    auto addSequence = [&](std::string const & genome, std::string const & sequenceName, std::string const & bases) {
+        Sequence sequence{nameIndex(genome), nameIndex(sequenceName), bases.size(), words.size(), 0};
+        // one word more, so that LinearGenomes::bases() can always read two words
+        words.resize(words.size() + bases.size() / 32 + 2, 0);
+        sequence.invalid = words.size();
+        words.resize(words.size() + bases.size() / 64 + 1, 0);
+        for (size_t i = 0; i < bases.size(); i++) {
+            unsigned code = baseCode(bases[i]);
+            if (code == 4) {
+                words[sequence.invalid + i / 64] |= uint64_t(1) << (i % 64);
+                code = 0;
+            }
+            words[sequence.bases + i / 32] |= uint64_t(code) << (2 * (i % 32));
+        }
+        sequences.push_back(sequence);
+    };
+    for (auto const & [genome, fasta] : genomeFastas) {
+        std::ifstream inf(fasta);
+        if (!inf) {
+            std::cout << "cannot read FASTA file " << fasta << '\n';
+            return false;
+        }
+        std::string line, sequenceName, bases;
+        bool inSequence = false;
+        while (std::getline(inf, line)) {
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            if (!line.empty() && line[0] == '>') {
+                if (inSequence) {
+                    addSequence(genome, sequenceName, bases);
+                }
+                sequenceName = line.substr(1, line.find_first_of(" \t") - 1);
+                bases.clear();
+                inSequence = true;
+            }
+            else {
+                bases += line;
+            }
+        }
+        if (inSequence) {
+            addSequence(genome, sequenceName, bases);
+        }
+    }
+
+    std::ofstream outf(path, std::ios::binary);
+    if (!outf) {
+        return false;
+    }
+    Header header{};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.nSequences = sequences.size();
+    header.nNames = names.size();
+    header.nWords = words.size();
+    std::vector<uint64_t> nameOffsets{0};
+    for (auto const & name : names) {
+        nameOffsets.push_back(nameOffsets.back() + name.size());
+    }
+    outf.write(reinterpret_cast<char const *>(&header), sizeof(header));
+    outf.write(reinterpret_cast<char const *>(sequences.data()), sequences.size() * sizeof(Sequence));
+    outf.write(reinterpret_cast<char const *>(nameOffsets.data()), nameOffsets.size() * sizeof(uint64_t));
+    for (auto const & name : names) {
+        outf.write(name.data(), name.size());
+    }
+    std::vector<char> padding((8 - nameOffsets.back() % 8) % 8, 0);
+    outf.write(padding.data(), padding.size());
+    outf.write(reinterpret_cast<char const *>(words.data()), words.size() * sizeof(uint64_t));
+    return(bool(outf));
+}
+
+LinearGenomes::LinearGenomes(std::string const & path_, size_t k_, size_t binsize_):path{path_},
+                                                                                     data{nullptr},
+                                                                                     fileSize{0},
+                                                                                     k{k_},
+                                                                                     binsize{binsize_} {
+    int fd = open(path.c_str(), O_RDONLY);
+    struct stat fileStat;
+    if (fd < 0 || fstat(fd, &fileStat) != 0) {
+        std::cout << "cannot open linear genomes " << path << '\n';
+        exit(1);
+    }
+    fileSize = fileStat.st_size;
+    if (fileSize < sizeof(Header)) {
+        std::cout << "linear genomes " << path << " is too short" << '\n';
+        exit(1);
+    }
+    data = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping stays valid
+    if (data == MAP_FAILED) {
+        std::cout << "cannot map linear genomes " << path << '\n';
+        exit(1);
+    }
+
+    char const * bytes = static_cast<char const *>(data);
+    header = reinterpret_cast<Header const *>(bytes);
+    if (std::memcmp(header->magic, magic, sizeof(magic)) != 0) {
+        std::cout << path << " is not a linear genomes file" << '\n';
+        exit(1);
+    }
+    size_t offset = sizeof(Header);
+    // points begin to the next section of n elements
+    auto section = [&](auto const * & begin, uint64_t n) {
+        begin = reinterpret_cast<std::decay_t<decltype(*begin)> const *>(bytes + offset);
+        offset += n * sizeof(*begin);
+        if (offset > fileSize) {
+            std::cout << "linear genomes " << path << " is truncated" << '\n';
+            exit(1);
+        }
+    };
+    section(sequences, header->nSequences);
+    section(nameOffsets, header->nNames + 1);
+    section(names, nameOffsets[header->nNames]);
+    offset += (8 - offset % 8) % 8;
+    section(words, header->nWords);
+    for (uint64_t i = 0; i < header->nSequences; i++) {
+        auto const & sequence = sequences[i];
+        if (sequence.genomeName >= header->nNames || sequence.sequenceName >= header->nNames
+            || sequence.bases + sequence.length / 32 + 2 > header->nWords
+            || sequence.invalid + sequence.length / 64 + 1 > header->nWords) {
+            std::cout << "linear genomes " << path << " is corrupt" << '\n';
+            exit(1);
+        }
+    }
+
+    unique.resize(header->nSequences);
+    for (size_t i = 0; i < header->nSequences; i++) {
+        MetagraphInterface::NodeAnnotation anno;
+        anno.genome = name(sequences[i].genomeName);
+        anno.sequence = name(sequences[i].sequenceName);
+        anno.reverse_strand = false;
+        anno.bin_idx = 0;
+        sequenceOfTrack[ColorClasses::trackID(anno)] = i;
+        markUnique(i, 2 * binsize);
+    }
+}
+
+LinearGenomes::~LinearGenomes() {
+    if (data != nullptr) {
+        munmap(data, fileSize);
+    }
+}
+
+std::string LinearGenomes::name(uint64_t nameIndex) const {
+    return std::string(names + nameOffsets[nameIndex],
+                       nameOffsets[nameIndex + 1] - nameOffsets[nameIndex]);
+}
+
+uint64_t LinearGenomes::bases(size_t sequence, uint64_t position) const {
+    uint64_t const * word = words + sequences[sequence].bases + position / 32;
+    unsigned shift = 2 * (position % 32);
+    return shift == 0 ? word[0] : word[0] >> shift | word[1] << (64 - shift);
+}
+
+// every (k-1)-mer is compared to the last occurrence of the same (k-1)-mer only,
+// if two occurrences are within distance, so are all occurrences between them
+void LinearGenomes::markUnique(size_t sequence, size_t distance) {
+    auto const & seq = sequences[sequence];
+    auto & bits = unique[sequence];
+    bits.assign(seq.length / 64 + 1, 0);
+    size_t m = k - 1;
+    if (k < 2 || seq.length < m) {
+        return;
+    }
+    // (k-1)-mers of up to 32 bases are their 2 bit code, longer ones are hashed,
+    // a collision only marks a repeat too much
+    auto key = [&](uint64_t position) {
+        uint64_t hash = 0;
+        for (size_t i = 0; i < m; i += 32) {
+            uint64_t chunk = bases(sequence, position + i);
+            if (m - i < 32) {
+                chunk &= (uint64_t(1) << (2 * (m - i))) - 1;
+            }
+            hash = i == 0 ? chunk : hash * 1000003 ^ chunk;
+        }
+        return hash;
+    };
+    std::unordered_map<uint64_t, uint64_t> lastOccurrence;
+    // (key, position) of the (k-1)-mers within distance, to remove the older ones from lastOccurrence
+    std::deque<std::pair<uint64_t, uint64_t>> window;
+    size_t nValidBases = 0;
+    for (uint64_t i = 0; i < seq.length; i++) {
+        bool isValid = (words[seq.invalid + i / 64] >> (i % 64) & 1) == 0;
+        nValidBases = isValid ? nValidBases + 1 : 0;
+        if (nValidBases < m) {
+            continue;
+        }
+        // the (k-1)-mer that ends at i
+        uint64_t position = i + 1 - m;
+        while (!window.empty() && window.front().second + distance < position) {
+            auto found = lastOccurrence.find(window.front().first);
+            if (found != lastOccurrence.end() && found->second == window.front().second) {
+                lastOccurrence.erase(found);
+            }
+            window.pop_front();
+        }
+        uint64_t kmerKey = key(position);
+        bits[position / 64] |= uint64_t(1) << (position % 64);
+        auto found = lastOccurrence.insert({kmerKey, position});
+        if (!found.second) {
+            uint64_t previous = found.first->second;
+            bits[previous / 64] &= ~(uint64_t(1) << (previous % 64));
+            bits[position / 64] &= ~(uint64_t(1) << (position % 64));
+            found.first->second = position;
+        }
+        window.push_back({kmerKey, position});
+    }
+}
+
+bool LinearGenomes::locate(ColorClasses::AnnoKey const & anno,
+                           std::string const & kmer,
+                           Locus & locus) const {
+    auto found = sequenceOfTrack.find(anno.track);
+    if (found == sequenceOfTrack.end() || kmer.size() != k) {
+        return false;
+    }
+    size_t sequence = found->second;
+    auto const & bits = unique[sequence];
+    // the first 32 bases of kmer are compared at once
+    size_t nCoded = std::min<size_t>(k, 32);
+    uint64_t code = 0;
+    for (size_t i = 0; i < k; i++) {
+        uint64_t baseID = baseCode(kmer[i]);
+        if (baseID == 4) {
+            return false;
+        }
+        if (i < nCoded) {
+            code |= baseID << (2 * i);
+        }
+    }
+    uint64_t mask = nCoded == 32 ? ~uint64_t(0) : (uint64_t(1) << (2 * nCoded)) - 1;
+    uint64_t length = sequences[sequence].length;
+    uint64_t end = std::min<uint64_t>(anno.bin_idx + binsize, length >= k ? length - k + 1 : 0);
+    for (uint64_t position = anno.bin_idx; position < end; position++) {
+        if ((bits[position / 64] >> (position % 64) & 1) == 0 || (bases(sequence, position) & mask) != code) {
+            continue;
+        }
+        bool isMatch = true;
+        for (size_t i = nCoded; i < k && isMatch; i++) {
+            isMatch = base(sequence, position + i) == baseCode(kmer[i]);
+        }
+        // the (k-1)-mer at position is unique within 2 * binsize, so there is no other match in the bin
+        if (isMatch) {
+            locus = Locus{sequence, position};
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t LinearGenomes::nEqualBases(size_t seqA, uint64_t a, size_t seqB, uint64_t b, bool backwards, size_t maxLength) const {
+    size_t n = 0;
+    while (n < maxLength) {
+        if (backwards && (a < n + 31 || b < n + 31)) {
+            // close to the start of a sequence base by base
+            if (a < n || b < n || base(seqA, a - n) != base(seqB, b - n)) {
+                break;
+            }
+            n++;
+            continue;
+        }
+        // backwards the 32 bases that end at a - n and b - n
+        uint64_t diff = backwards ?
+                        bases(seqA, a - n - 31) ^ bases(seqB, b - n - 31) :
+                        bases(seqA, a + n) ^ bases(seqB, b + n);
+        if (diff != 0) {
+            n += (backwards ? __builtin_clzll(diff) : __builtin_ctzll(diff)) / 2;
+            break;
+        }
+        n += 32;
+    }
+    return std::min(n, maxLength);
+}
+
+size_t LinearGenomes::nSetBits(std::vector<uint64_t> const & bitmap, uint64_t position, bool backwards, size_t maxLength) {
+    size_t n = 0;
+    while (n < maxLength) {
+        if (!backwards) {
+            uint64_t p = position + n;
+            if (p / 64 >= bitmap.size()) {
+                break;
+            }
+            uint64_t notSet = ~(bitmap[p / 64] >> (p % 64));
+            size_t nSet = notSet == 0 ? 64 : __builtin_ctzll(notSet);
+            n += nSet;
+            if (nSet < 64 - p % 64) {
+                break;
+            }
+        }
+        else {
+            if (position < n) {
+                break;
+            }
+            uint64_t p = position - n;
+            // bit p is the highest bit
+            uint64_t notSet = ~(bitmap[p / 64] << (63 - p % 64));
+            size_t nSet = notSet == 0 ? 64 : __builtin_clzll(notSet);
+            n += nSet;
+            if (nSet < p % 64 + 1 || p < 64) {
+                break;
+            }
+        }
+    }
+    return std::min(n, maxLength);
+}
+
+// step j from the kmer at p reaches the kmer at p+j downStream, which needs the (k-1)-mers
+// at p+j and p+j+1 to be unique, upStream the ones at p-j+1 and p-j, see the header.
+// So n steps need n + 1 set bits from p+1 on, or from p on backwards
+size_t LinearGenomes::syncedSteps(std::vector<Locus> const & loci,
+                                  bool upStream,
+                                  size_t maxSteps) const {
+    size_t nSteps = maxSteps;
+    for (auto const & locus : loci) {
+        auto const & bits = unique[locus.sequence];
+        if (upStream) {
+            size_t nUnique = nSetBits(bits, locus.position, true, nSteps + 1);
+            nSteps = std::min({nSteps, nUnique == 0 ? 0 : nUnique - 1, (size_t)locus.position});
+        }
+        else {
+            size_t nUnique = nSetBits(bits, locus.position + 1, false, nSteps + 1);
+            nSteps = std::min(nSteps, nUnique == 0 ? 0 : nUnique - 1);
+        }
+    }
+    for (size_t i = 1; i < loci.size() && nSteps > 0; i++) {
+        nSteps = upStream ?
+                 nEqualBases(loci[0].sequence, loci[0].position - 1,
+                             loci[i].sequence, loci[i].position - 1, true, nSteps) :
+                 nEqualBases(loci[0].sequence, loci[0].position + k,
+                             loci[i].sequence, loci[i].position + k, false, nSteps);
+    }
+    return nSteps;
+}
+
+char LinearGenomes::nextBase(Locus const & locus, bool upStream) const {
+    return "ACGT"[upStream ? base(locus.sequence, locus.position - 1) :
+                             base(locus.sequence, locus.position + k)];
+}
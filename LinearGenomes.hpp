@@ -0,0 +1,119 @@
+#ifndef _LinearGenomes_HPP_
+#define _LinearGenomes_HPP_
+
+#include "ColorClasses.hpp"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/* The sequences of the genomes of the graph, 2 bit packed and memory mapped
+* \details Used by SeedExtension::fastForwardUnitig() to extend a bundle along the
+* sequences of its annotations instead of matching annotations node by node: as long
+* as all annotations continue with the same base, they stay in one bundle, and their
+* next node is the neighbour with that base. The bases are compared 32 at a time.
+* This is only equal to the extension through the graph if
+*   - the annotations are on the forward strand and bin_idx is the bin of the first
+*     base of the kmer in its sequence, i.e. position / binsize * binsize,
+*   - the (k-1)-mers of the kmers do not occur again in the same sequence within
+*     2 * binsize bases, otherwise the graph would match annotations of the repeat
+*     (e.g. short tandem repeats). Such positions are marked when the file is mapped,
+*     and the extension falls back to the graph there.
+*
+* Layout (native byte order, every section 8 byte aligned):
+*   Header
+*   Sequence sequences[nSequences]
+*   uint64_t nameOffsets[nNames + 1]   name i: names[nameOffsets[i], nameOffsets[i+1])
+*   char     names[nameOffsets[nNames]], padded to 8 bytes
+*   uint64_t words[]                   bases, 32 per word, base i at bits 2 * (i % 32),
+*                                      and a bitmap of the bases that are no A, C, G or T
+*/
+class LinearGenomes {
+public:
+    struct Header {
+        char magic[8];
+        uint64_t nSequences;
+        uint64_t nNames;
+        uint64_t nWords;
+    };
+    struct Sequence {
+        //! indices into the name table of the file
+        uint32_t genomeName;
+        uint32_t sequenceName;
+        uint64_t length;
+        //! first word of the bases and of the bitmap of invalid bases in words
+        uint64_t bases;
+        uint64_t invalid;
+    };
+    //! the start of a kmer in a sequence
+    struct Locus {
+        size_t sequence;
+        uint64_t position;
+    };
+
+    //! reads the FASTA files of the genomes (genome name, path) and writes them to path
+    /*! the sequence names are the headers up to the first whitespace
+     * returns false if a FASTA file cannot be read or path cannot be written
+     */
+    static bool build(std::vector<std::pair<std::string, std::string>> const & genomeFastas,
+                      std::string const & path);
+
+    //! maps the file at path and marks the repeats for graphs with kmer length k, exits if it is not valid
+    LinearGenomes(std::string const & path, size_t k, size_t binsize);
+    ~LinearGenomes();
+    LinearGenomes(LinearGenomes const &) = delete;
+    LinearGenomes & operator=(LinearGenomes const &) = delete;
+
+    //! finds the kmer in the bin of anno, returns false if it is not there exactly once or in a repeat
+    bool locate(ColorClasses::AnnoKey const & anno,
+                std::string const & kmer,
+                Locus & locus) const;
+    //! returns the number of steps all loci can be extended with the same bases outside of repeats
+    /*! at most maxSteps, in the bases before the kmers if upStream */
+    size_t syncedSteps(std::vector<Locus> const & loci,
+                       bool upStream,
+                       size_t maxSteps) const;
+    //! returns the base the kmer at locus is extended with
+    char nextBase(Locus const & locus, bool upStream) const;
+
+    size_t nSequences() const {
+        return header->nSequences;
+    }
+
+    static constexpr char magic[8] = {'L', 'I', 'N', 'G', 'E', 'N', 'O', '1'};
+
+private:
+    std::string name(uint64_t nameIndex) const;
+    //! the base at position of sequence, 0 to 3 for A, C, G, T
+    unsigned base(size_t sequence, uint64_t position) const {
+        auto const & seq = sequences[sequence];
+        return (words[seq.bases + position / 32] >> (2 * (position % 32))) & 3;
+    }
+    //! the 32 bases starting at position, the bases after the end of the sequence are 0
+    uint64_t bases(size_t sequence, uint64_t position) const;
+    //! the number of equal bases at a, b and then forwards, or backwards if backwards
+    size_t nEqualBases(size_t seqA, uint64_t a, size_t seqB, uint64_t b, bool backwards, size_t maxLength) const;
+    //! the number of set bits of bitmap from position on, forwards or backwards
+    static size_t nSetBits(std::vector<uint64_t> const & bitmap, uint64_t position, bool backwards, size_t maxLength);
+    //! sets unique[i] for the (k-1)-mers that do not occur again within distance of it
+    void markUnique(size_t sequence, size_t distance);
+
+    std::string path;
+    void * data;
+    size_t fileSize;
+    Header const * header;
+    Sequence const * sequences;
+    uint64_t const * nameOffsets;
+    char const * names;
+    uint64_t const * words;
+    size_t k;
+    size_t binsize;
+    //! the sequence of every forward track of the graph
+    std::unordered_map<ColorClasses::TrackID, size_t> sequenceOfTrack;
+    //! per sequence, bit i is set if the (k-1)-mer at i consists of A, C, G, T and is no repeat
+    std::vector<std::vector<uint64_t>> unique;
+};
+
+#endif //_LinearGenomes_HPP_
@@ -0,0 +1,399 @@
+#include "MultiSeedExtension.hpp"
+
+#include "SeedExtension.hpp"
+#include "NodeCache.hpp"
+#include "SeedFile.hpp"
+#include "ColorClasses.hpp"
+#include "TouchedNodes.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+std::vector<MultiSeedExtension::Seed>
+MultiSeedExtension::seedsOf(std::shared_ptr<SeedFile const> seedFile) {
+    std::vector<Seed> seeds(seedFile->size());
+    for (size_t i = 0; i < seeds.size(); i++) {
+        seeds[i].seedFile = seedFile;
+        seeds[i].seedFileIndex = i;
+    }
+    return seeds;
+}
+
+void MultiSeedExtension::initSeed(SeedExtension & extension,
+                                  Seed const & seed,
+                                  std::shared_ptr<IdentifierMapping const> idMap) {
+    if (seed.seedFile) {
+        extension.initFirstTip(*seed.seedFile, seed.seedFileIndex, idMap);
+    }
+    else {
+        extension.initFirstTip(seed.nodeIDs, seed.link, idMap);
+    }
+}
+
+void MultiSeedExtension::extend(std::vector<Seed> const & seeds,
+                                size_t sufficientMaxScore,
+                                callbackType const & onExtended) {
+    std::vector<size_t> seedIndices(seeds.size());
+    std::iota(seedIndices.begin(), seedIndices.end(), 0);
+    extend(seeds, seedIndices, sufficientMaxScore, onExtended);
+}
+
+void MultiSeedExtension::extend(std::vector<Seed> const & seeds,
+                                std::vector<size_t> const & seedIndices,
+                                size_t sufficientMaxScore,
+                                callbackType const & onExtended) {
+    auto scheduled = schedule(seeds, seedIndices, schedulingWindow);
+    for (size_t begin = 0; begin < scheduled.size(); begin += groupSize) {
+        size_t end = std::min(begin + groupSize, scheduled.size());
+        extendGroup(seeds, scheduled, begin, end, sufficientMaxScore, onExtended);
+    }
+}
+
+void MultiSeedExtension::extendGroup(std::vector<Seed> const & seeds,
+                                     std::vector<size_t> const & seedIndices,
+                                     size_t begin,
+                                     size_t end,
+                                     size_t sufficientMaxScore,
+                                     callbackType const & onExtended) {
+    // every seed prefetches its next frontier in its own slot, so the prefetches of
+    // all seeds run while the other seeds are extended
+    while (extensions.size() < end - begin) {
+        if (config) {
+            extensions.emplace_back(graph.withPrefetchSlot(extensions.size()), config, binsize);
+        }
+        else {
+            extensions.emplace_back(graph.withPrefetchSlot(extensions.size()), xdrop, binsize);
+        }
+    }
+    for (size_t i = begin; i < end; i++) {
+        auto const & seed = seeds[seedIndices[i]];
+        extensions[i - begin].memoryCap = memoryCap;
+        extensions[i - begin].fastForward = fastForward;
+        extensions[i - begin].linearGenomes = linearGenomes;
+        extensions[i - begin].cyclePolicy = cyclePolicy;
+        extensions[i - begin].stepBudget = stepBudget;
+        extensions[i - begin].timeBudget = timeBudget;
+        extensions[i - begin].recordTouchedNodes = recordTouchedNodes;
+        initSeed(extensions[i - begin], seed, idMap);
+    }
+    // same order as SeedExtension::extend(): first downStream, then upStream
+    for (bool upStream : {false, true}) {
+        std::vector<bool> active(end - begin, true);
+        bool anyActive = true;
+        while (anyActive) {
+            anyActive = false;
+            for (size_t j = 0; j < end - begin; j++) {
+                if (!active[j]) {
+                    continue;
+                }
+                auto & extension = extensions[j];
+                auto & tipsHis = upStream ? extension.upStreamTipsHistory : extension.tipsHistory;
+                active[j] = extension.extendOneStep(sufficientMaxScore, tipsHis, upStream);
+                anyActive = anyActive || active[j];
+            }
+            // all seeds are between two steps
+            graph.trim();
+
+            size_t groupMemoryUsage = 0;
+            for (size_t j = 0; j < end - begin; j++) {
+                groupMemoryUsage += extensions[j].memoryUsage();
+            }
+            peakGroupMemoryUsage = std::max(peakGroupMemoryUsage, groupMemoryUsage);
+        }
+    }
+    for (size_t i = begin; i < end; i++) {
+        auto const & extension = extensions[i - begin];
+        peakMemoryUsage = std::max(peakMemoryUsage, extension.peakMemoryUsage);
+        if (extension.memoryCapReached) {
+            nMemoryCapReached++;
+        }
+        if (extension.truncated) {
+            nTruncated++;
+        }
+        nCycles += extension.nCycles;
+        onExtended(seedIndices[i], extension);
+    }
+}
+
+std::vector<ExtensionResult> MultiSeedExtension::run(std::vector<Seed> const & seeds,
+                                                     size_t sufficientMaxScore) {
+    std::vector<size_t> seedIndices(seeds.size());
+    std::iota(seedIndices.begin(), seedIndices.end(), 0);
+    return run(seeds, seedIndices, sufficientMaxScore);
+}
+
+std::vector<ExtensionResult> MultiSeedExtension::run(std::vector<Seed> const & seeds,
+                                                     std::vector<size_t> const & seedIndices,
+                                                     size_t sufficientMaxScore) {
+    std::vector<ExtensionResult> results(seedIndices.size());
+    // position of a seed in seedIndices and results
+    std::unordered_map<size_t, size_t> positions;
+    std::vector<size_t> seedsToExtend;
+    if (checkpoint) {
+        checkpoint->load(checkpointHeader(seeds, sufficientMaxScore));
+    }
+    for (size_t i = 0; i < seedIndices.size(); i++) {
+        positions[seedIndices[i]] = i;
+        if (checkpoint && checkpoint->isDone(seedIndices[i])) {
+            results[i] = checkpoint->result(seedIndices[i]);
+        }
+        else {
+            seedsToExtend.push_back(seedIndices[i]);
+        }
+    }
+    auto addResult = [&](ExtensionResult const & result) {
+        results[positions.at(result.seedIndex)] = result;
+        if (checkpoint) {
+            checkpoint->add(result);
+        }
+    };
+    // (seed, the seed with the same duplicateKey() that is extended)
+    std::vector<std::pair<size_t, size_t>> duplicates;
+    if (deduplicateSeeds) {
+        std::unordered_map<std::string, size_t> firstOfKey;
+        std::vector<size_t> representatives;
+        for (auto seedIndex : seedsToExtend) {
+            auto first = firstOfKey.insert({duplicateKey(seeds[seedIndex]), seedIndex});
+            if (first.second) {
+                representatives.push_back(seedIndex);
+            }
+            else {
+                duplicates.push_back({seedIndex, first.first->second});
+            }
+        }
+        seedsToExtend = representatives;
+    }
+    auto onExtended = [&](size_t seedIndex, SeedExtension const & seedExtension) {
+        addResult(ExtensionResult(seedIndex, seedExtension));
+        if (recordTouchedNodes) {
+            touchedNodes.push_back(TouchedNodes(seedIndex, seedHash(seeds[seedIndex]), seedExtension));
+        }
+    };
+    extend(seeds, seedsToExtend, sufficientMaxScore, onExtended);
+
+    for (auto const & [seedIndex, representative] : duplicates) {
+        auto duplicate = results[positions.at(representative)];
+        duplicate.seedIndex = seedIndex;
+        addResult(duplicate);
+        nCopiedDuplicates++;
+    }
+    if (checkpoint) {
+        checkpoint->flush();
+    }
+    return results;
+}
+
+std::vector<ExtensionResult>
+MultiSeedExtension::runIncremental(std::vector<Seed> const & seeds,
+                                   size_t sufficientMaxScore,
+                                   std::vector<ExtensionResult> const & previousResults,
+                                   std::vector<TouchedNodes> const & previousTouched) {
+    std::unordered_map<size_t, ExtensionResult const *> resultOfSeed;
+    for (auto const & result : previousResults) {
+        resultOfSeed[result.seedIndex] = &result;
+    }
+    std::vector<ExtensionResult> results(seeds.size());
+    std::vector<bool> kept(seeds.size(), false);
+    touchedNodes.clear();
+    for (auto const & touched : previousTouched) {
+        auto result = resultOfSeed.find(touched.seedIndex);
+        if (touched.seedIndex >= seeds.size() || result == resultOfSeed.end() ||
+            kept[touched.seedIndex] ||
+            touched.isChanged(graph, seedHash(seeds[touched.seedIndex]))) {
+            continue;
+        }
+        results[touched.seedIndex] = *result->second;
+        kept[touched.seedIndex] = true;
+        touchedNodes.push_back(touched);
+        nKeptResults++;
+    }
+    std::vector<size_t> seedsToExtend;
+    for (size_t i = 0; i < seeds.size(); i++) {
+        if (!kept[i]) {
+            seedsToExtend.push_back(i);
+        }
+    }
+    // the next incremental run needs the records of the extended seeds
+    bool record = recordTouchedNodes;
+    recordTouchedNodes = true;
+    auto extended = run(seeds, seedsToExtend, sufficientMaxScore);
+    recordTouchedNodes = record;
+    for (size_t i = 0; i < seedsToExtend.size(); i++) {
+        results[seedsToExtend[i]] = extended[i];
+    }
+    return results;
+}
+
+// FNV-1a, so that the hash is the same in every run
+static uint64_t addToHash(uint64_t hash, std::string const & str) {
+    for (unsigned char c : str) {
+        hash = (hash ^ c) * 1099511628211ULL;
+    }
+    // separates the strings
+    return (hash ^ 0xff) * 1099511628211ULL;
+}
+
+uint64_t MultiSeedExtension::seedHash(Seed const & seed) const {
+    uint64_t hash = 14695981039346656037ULL;
+    // (genome, sequence, reverse, position)
+    std::vector<std::tuple<std::string, std::string, bool, uint64_t>> occurrences;
+    if (seed.seedFile) {
+        auto fileSeed = seed.seedFile->seed(seed.seedFileIndex);
+        for (size_t i = 0; i < fileSeed.nNodeIDs; i++) {
+            hash = addToHash(hash, std::to_string(fileSeed.nodeIDs[i]));
+        }
+        for (size_t i = 0; i < fileSeed.nOccurrences; i++) {
+            auto anno = seed.seedFile->annoKey(fileSeed.occurrences[i]);
+            auto track = ColorClasses::track(anno.track);
+            occurrences.push_back({track.genome, track.sequence, track.reverse_strand, anno.bin_idx});
+        }
+    }
+    else {
+        for (auto nodeID : seed.nodeIDs) {
+            hash = addToHash(hash, std::to_string(nodeID));
+        }
+        for (auto & occurrence : seed.link->occurrence()) {
+            occurrences.push_back({idMap->queryGenomeName(occurrence.genome()),
+                                   idMap->querySequenceName(occurrence.sequence()),
+                                   occurrence.reverse(),
+                                   (uint64_t)occurrence.position()});
+        }
+    }
+    std::sort(occurrences.begin(), occurrences.end());
+    for (auto const & occurrence : occurrences) {
+        hash = addToHash(hash, std::get<0>(occurrence));
+        hash = addToHash(hash, std::get<1>(occurrence));
+        hash = addToHash(hash, std::to_string(std::get<2>(occurrence)));
+        hash = addToHash(hash, std::to_string(std::get<3>(occurrence)));
+    }
+    return hash;
+}
+
+// the settings of the run, incl. everything that can change the result of a seed, except the graph
+std::string MultiSeedExtension::checkpointHeader(std::vector<Seed> const & seeds,
+                                                 size_t sufficientMaxScore) const {
+    uint64_t hash = 14695981039346656037ULL;
+    for (auto const & seed : seeds) {
+        hash = addToHash(hash, std::to_string(seedHash(seed)));
+    }
+    std::ostringstream header;
+    header << "seeds " << seeds.size() << ' ' << hash
+           << "\tbinsize " << binsize
+           << "\txdrop " << xdrop
+           << "\tsufficientMaxScore " << sufficientMaxScore
+           << "\tstepBudget " << stepBudget
+           << "\ttimeBudget " << timeBudget
+           << "\tmemoryCap " << memoryCap
+           << "\tcyclePolicy " << cyclePolicy
+           << "\tlinearGenomes " << (linearGenomes != nullptr)
+           << "\tdeduplicateSeeds " << deduplicateSeeds;
+    // the mask of a graph is identified by its thresholds
+    auto repeatMask = graph.repeatMask();
+    if (repeatMask) {
+        header << "\trepeatMask " << repeatMask->maxAnnotations()
+               << ' ' << repeatMask->maxDegree()
+               << ' ' << repeatMask->nRepeatNodes()
+               << "\trepeatPolicy " << graph.repeatPolicy();
+    }
+    return header.str();
+}
+
+MetagraphInterface::NodeID MultiSeedExtension::minNodeID(Seed const & seed) {
+    if (seed.seedFile) {
+        auto fileSeed = seed.seedFile->seed(seed.seedFileIndex);
+        return fileSeed.nNodeIDs == 0 ?
+               0 :
+               *std::min_element(fileSeed.nodeIDs, fileSeed.nodeIDs + fileSeed.nNodeIDs);
+    }
+    return seed.nodeIDs.empty() ?
+           0 :
+           *std::min_element(seed.nodeIDs.begin(), seed.nodeIDs.end());
+}
+
+std::vector<size_t> MultiSeedExtension::shard(std::vector<Seed> const & seeds,
+                                              size_t nShards,
+                                              size_t shardIndex) {
+    std::vector<std::pair<MetagraphInterface::NodeID, size_t>> keys;
+    for (size_t i = 0; i < seeds.size(); i++) {
+        keys.push_back({minNodeID(seeds[i]), i});
+    }
+    std::sort(keys.begin(), keys.end());
+    nShards = nShards == 0 ? 1 : nShards;
+    // the first seeds.size() % nShards shards get one seed more
+    size_t shardSize = seeds.size() / nShards;
+    size_t nLargerShards = seeds.size() % nShards;
+    size_t begin = shardIndex * shardSize + std::min(shardIndex, nLargerShards);
+    size_t end = shardIndex < nShards ?
+                 begin + shardSize + (shardIndex < nLargerShards ? 1 : 0) :
+                 begin;
+    std::vector<size_t> seedIndices;
+    for (size_t i = std::min(begin, keys.size()); i < std::min(end, keys.size()); i++) {
+        seedIndices.push_back(keys[i].second);
+    }
+    return seedIndices;
+}
+
+std::vector<size_t> MultiSeedExtension::schedule(std::vector<Seed> const & seeds,
+                                                 std::vector<size_t> const & seedIndices,
+                                                 size_t window) {
+    if (window == 0) {
+        return seedIndices;
+    }
+    std::vector<size_t> scheduled;
+    for (size_t begin = 0; begin < seedIndices.size(); begin += window) {
+        size_t end = std::min(begin + window, seedIndices.size());
+        std::vector<std::tuple<MetagraphInterface::NodeID, size_t, size_t>> keys;
+        for (size_t i = begin; i < end; i++) {
+            keys.push_back({minNodeID(seeds[seedIndices[i]]), i, seedIndices[i]});
+        }
+        std::sort(keys.begin(), keys.end());
+        for (auto const & key : keys) {
+            scheduled.push_back(std::get<2>(key));
+        }
+    }
+    return scheduled;
+}
+
+// node IDs and occurrences are sorted, bc their order does not change the result
+std::string MultiSeedExtension::duplicateKey(Seed const & seed) const {
+    std::vector<MetagraphInterface::NodeID> nodeIDs;
+    // (genome, sequence, position, reverse)
+    std::vector<std::tuple<std::string, std::string, uint64_t, bool>> occurrences;
+    if (seed.seedFile) {
+        auto fileSeed = seed.seedFile->seed(seed.seedFileIndex);
+        nodeIDs.assign(fileSeed.nodeIDs, fileSeed.nodeIDs + fileSeed.nNodeIDs);
+        for (size_t i = 0; i < fileSeed.nOccurrences; i++) {
+            auto anno = seed.seedFile->annoKey(fileSeed.occurrences[i]);
+            auto track = ColorClasses::track(anno.track);
+            occurrences.push_back({track.genome, track.sequence, anno.bin_idx, track.reverse_strand});
+        }
+    }
+    else {
+        nodeIDs = seed.nodeIDs;
+        for (auto & occurrence : seed.link->occurrence()) {
+            occurrences.push_back({idMap->queryGenomeName(occurrence.genome()),
+                                   idMap->querySequenceName(occurrence.sequence()),
+                                   (uint64_t)occurrence.position(),
+                                   occurrence.reverse()});
+        }
+    }
+    std::sort(nodeIDs.begin(), nodeIDs.end());
+    nodeIDs.erase(std::unique(nodeIDs.begin(), nodeIDs.end()), nodeIDs.end());
+    std::sort(occurrences.begin(), occurrences.end());
+    std::string key;
+    for (auto nodeID : nodeIDs) {
+        key += std::to_string(nodeID) + '\t';
+    }
+    for (auto const & occurrence : occurrences) {
+        key += '\n' + std::get<0>(occurrence) + '\t' + std::get<1>(occurrence) + '\t'
+             + std::to_string(std::get<2>(occurrence))
+             + (std::get<3>(occurrence) ? "\t-" : "\t+");
+    }
+    return key;
+}
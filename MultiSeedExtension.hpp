@@ -0,0 +1,221 @@
+#ifndef _MultiSeedExtension_HPP_
+#define _MultiSeedExtension_HPP_
+
+#include "Checkpoint.hpp"
+#include "Configuration.h"
+#include "ExtensionResult.hpp"
+#include "IdentifierMapping.h"
+#include "MetagraphInterface.h"
+#include "Link.h"
+#include "LinearGenomes.hpp"
+#include "NodeCache.hpp"
+#include "SeedExtension.hpp"
+#include "SeedFile.hpp"
+#include "TouchedNodes.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+/* Extends groups of seeds in lockstep over a shared frontier
+* All SeedExtension s of a group share one NodeCache, so a node that lies in the
+* frontier of several seeds is fetched from the graph only once. Between two steps the
+* NodeCache is trimmed to its capacity (e.g. NodeCache::defaultCapacity).
+* Every seed keeps its own bundles, scores and xDrop state, hence the results
+* are identical to extending the seeds one after another.
+* If the NodeCache prefetches, every seed of a group has its own prefetch slot
+* (see NodeCache::withPrefetchSlot()): after its step a seed fetches the neighbours
+* of its next frontier in the background, while the other seeds of the group make
+* their steps, so up to groupSize prefetches are in flight.
+*/
+class MultiSeedExtension {
+
+public:
+    //! a seed as it is passed to SeedExtension::initFirstTip()
+    /*! either nodeIDs and link or a seed of a SeedFile */
+    struct Seed {
+        std::vector<MetagraphInterface::NodeID> nodeIDs;
+        LinkPtr link;
+        std::shared_ptr<SeedFile const> seedFile = nullptr;
+        size_t seedFileIndex = 0;
+    };
+    //! returns all seeds of seedFile, without copying them out of the file
+    static std::vector<Seed> seedsOf(std::shared_ptr<SeedFile const> seedFile);
+    //! inits extension with seed, see SeedExtension::initFirstTip()
+    static void initSeed(SeedExtension & extension,
+                         Seed const & seed,
+                         std::shared_ptr<IdentifierMapping const> idMap);
+    //! is called with the index of a seed and its finished extension
+    using callbackType = std::function<void(size_t, SeedExtension const &)>;
+
+    MultiSeedExtension(NodeCache graph_,
+                       std::shared_ptr<Configuration const> config_,
+                       std::shared_ptr<IdentifierMapping const> idMap_,
+                       size_t binsize_,
+                       size_t groupSize_):
+                       graph{graph_},
+                       config{config_},
+                       xdrop{config_ ? config_->xdrop() : 0},
+                       idMap{idMap_},
+                       binsize{binsize_},
+                       groupSize{groupSize_ == 0 ? 1 : groupSize_},
+                       extensions{},
+                       checkpoint{} {}
+
+    //! without Configuration and IdentifierMapping, for seeds of a SeedFile, e.g. from a trace
+    MultiSeedExtension(NodeCache graph_,
+                       uint64_t xdrop_,
+                       size_t binsize_,
+                       size_t groupSize_):
+                       graph{graph_},
+                       config{},
+                       xdrop{xdrop_},
+                       idMap{},
+                       binsize{binsize_},
+                       groupSize{groupSize_ == 0 ? 1 : groupSize_},
+                       extensions{},
+                       checkpoint{} {}
+
+    //! extends all seeds, groupSize of them at a time in lockstep
+    /*! onExtended is called for every seed in the order of seeds,
+     * or in the order of schedule() if schedulingWindow is set
+     */
+    void extend(std::vector<Seed> const & seeds,
+                size_t sufficientMaxScore,
+                callbackType const & onExtended);
+    //! extends the seeds with the indices in seedIndices in this order, see above
+    void extend(std::vector<Seed> const & seeds,
+                std::vector<size_t> const & seedIndices,
+                size_t sufficientMaxScore,
+                callbackType const & onExtended);
+    //! extends the seeds seedIndices[begin], ..., seedIndices[end - 1] in lockstep
+    void extendGroup(std::vector<Seed> const & seeds,
+                     std::vector<size_t> const & seedIndices,
+                     size_t begin,
+                     size_t end,
+                     size_t sufficientMaxScore,
+                     callbackType const & onExtended);
+    //! extends all seeds and returns their results in the order of seeds
+    /*! if a checkpoint is set, seeds that are done in it are not extended again
+     * and the results of the other seeds are added to it
+     */
+    std::vector<ExtensionResult> run(std::vector<Seed> const & seeds,
+                                     size_t sufficientMaxScore);
+    //! same as above for the seeds with the indices in seedIndices, returns their results in this order
+    std::vector<ExtensionResult> run(std::vector<Seed> const & seeds,
+                                     std::vector<size_t> const & seedIndices,
+                                     size_t sufficientMaxScore);
+    //! extends only the seeds whose result can differ from previousResults, see TouchedNodes
+    /*! previousResults and previousTouched are from an earlier run with recordTouchedNodes,
+     * e.g. before genomes were added to the graph. A seed is extended again if it has no
+     * result or no record or if TouchedNodes::isChanged(), the results of the other seeds
+     * are kept. Returns the results in the order of seeds, afterwards touchedNodes holds
+     * the records of all seeds that have one.
+     */
+    std::vector<ExtensionResult> runIncremental(std::vector<Seed> const & seeds,
+                                                size_t sufficientMaxScore,
+                                                std::vector<ExtensionResult> const & previousResults,
+                                                std::vector<TouchedNodes> const & previousTouched);
+    //! returns a hash of the node IDs and occurrences of a seed, see TouchedNodes::seedHash
+    uint64_t seedHash(Seed const & seed) const;
+    //! returns the header of the checkpoint of a run of seeds, see Checkpoint
+    /*! It holds a hash of all seeds (see seedHash()) and the settings of the run, i.e.
+     * the parameters that change their results, the repeat mask of graph with its policy,
+     * and whether linearGenomes and deduplicateSeeds are used. The graph is not in it,
+     * it has to be the same for a resumed run.
+     */
+    std::string checkpointHeader(std::vector<Seed> const & seeds,
+                                 size_t sufficientMaxScore) const;
+    //! returns a key that is equal for seeds with the same node IDs and occurrences
+    /*! i.e. for seeds that have the same result */
+    std::string duplicateKey(Seed const & seed) const;
+    //! returns the indices of the seeds of shard shardIndex of nShards, see below
+    /*! The seeds are sorted by their smallest node ID (ties by index) and cut into
+     * nShards contiguous parts whose sizes differ by at most one. So every shard
+     * covers a region of the graph, which keeps its NodeCache warm, and the
+     * partition only depends on the seeds. The indices are returned in this order,
+     * which is also a good order to extend them.
+     * The results of all shards (see ExtensionResult::writeAll()) are combined with
+     * ExtensionResult::merge(), e.g. by the mergeShards program.
+     */
+    static std::vector<size_t> shard(std::vector<Seed> const & seeds,
+                                     size_t nShards,
+                                     size_t shardIndex);
+    //! returns seedIndices, where every window consecutive seeds are sorted by their smallest node ID
+    /*! ties keep their order. So seeds that lie in the same region of the graph are
+     * extended one after another while the NodeCache still holds that region, but a
+     * seed is not moved by more than window positions, i.e. only window seeds have to
+     * be buffered when they arrive as a stream. window 0 keeps the order.
+     */
+    static std::vector<size_t> schedule(std::vector<Seed> const & seeds,
+                                        std::vector<size_t> const & seedIndices,
+                                        size_t window);
+    //! returns the smallest node ID of a seed
+    static MetagraphInterface::NodeID minNodeID(Seed const & seed);
+
+    //! shared by all SeedExtension s
+    NodeCache graph;
+    std::shared_ptr<Configuration const> config;
+    //! config->xdrop(), if there is a config
+    uint64_t xdrop;
+    std::shared_ptr<IdentifierMapping const> idMap;
+    size_t binsize;
+    //! number of seeds that are extended in lockstep
+    size_t groupSize;
+    //! one SeedExtension per seed of a group, reused for every group
+    std::vector<SeedExtension> extensions;
+    //! the seeds are reordered by schedule() with this window before they are extended, 0 means not at all
+    /*! run() still returns the results in the order of the seeds */
+    size_t schedulingWindow = 0;
+    //! used by run() to resume an interrupted run, nullptr if not wanted
+    std::shared_ptr<Checkpoint> checkpoint;
+
+    //! run() extends only one seed of every duplicateKey(), the others get a copy of its result
+    /*! A reverse complement twin of a seed is extended itself: the strands of the
+     * annotations are not symmetric (e.g. bins only transition in one direction on a
+     * strand), so its result cannot be mirrored from the result of the seed.
+     */
+    bool deduplicateSeeds = false;
+    //! number of seeds whose result was copied from a duplicate
+    size_t nCopiedDuplicates = 0;
+
+    //! run() appends a TouchedNodes for every seed it extends to touchedNodes
+    /*! seeds whose result is taken from the checkpoint or from a duplicate get none,
+     * so runIncremental() extends them again
+     */
+    bool recordTouchedNodes = false;
+    std::vector<TouchedNodes> touchedNodes;
+    //! number of seeds whose result runIncremental() kept
+    size_t nKeptResults = 0;
+
+    //! passed to SeedExtension::fastForward of every seed
+    bool fastForward = false;
+    //! passed to SeedExtension::linearGenomes of every seed
+    std::shared_ptr<LinearGenomes const> linearGenomes;
+    //! passed to SeedExtension::cyclePolicy of every seed
+    SeedExtension::CyclePolicy cyclePolicy = SeedExtension::ignoreCycles;
+    //! sum of SeedExtension::nCycles of all extended seeds
+    size_t nCycles = 0;
+
+    // memory accounting
+    //! passed to SeedExtension::memoryCap of every seed, 0 means unlimited
+    size_t memoryCap = 0;
+    //! max SeedExtension::peakMemoryUsage of all extended seeds
+    size_t peakMemoryUsage = 0;
+    //! max sum of the memory held by the seeds of one group
+    size_t peakGroupMemoryUsage = 0;
+    //! number of seeds that were stopped bc they reached memoryCap
+    size_t nMemoryCapReached = 0;
+
+    // budget per seed, see SeedExtension::stepBudget
+    //! passed to SeedExtension::stepBudget of every seed
+    uint64_t stepBudget = 0;
+    //! passed to SeedExtension::timeBudget of every seed
+    double timeBudget = 0;
+    //! number of seeds that were truncated bc they reached the budget
+    size_t nTruncated = 0;
+};
+
+#endif //_MultiSeedExtension_HPP_
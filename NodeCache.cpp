@@ -0,0 +1,232 @@
+#include "NodeCache.hpp"
+
+#include "MetagraphInterface.h"
+#include "ColorClasses.hpp"
+#include "GraphTrace.hpp"
+#include "RepeatMask.hpp"
+
+#include <algorithm>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// the graph is queried without holding the lock, so concurrent calls may fetch a node twice,
+// but only the first result is stored
+template <typename T, typename Fetch>
+T const & NodeCache::Storage::get(MetagraphInterface::NodeID nodeID,
+                                  T Node::* value,
+                                  bool Node::* has,
+                                  Fetch fetch) {
+    Node * node;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        node = &nodes[nodeID]; // elements of an unordered_map dont move on insertion
+        if (node->*has) {
+            nHits++;
+            return node->*value;
+        }
+        nMisses++;
+    }
+    T fetched = fetch();
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!(node->*has)) {
+        node->*value = std::move(fetched);
+        node->*has = true;
+    }
+    return node->*value;
+}
+
+std::vector<MetagraphInterface::NodeID> const &
+NodeCache::getOutgoing(MetagraphInterface::NodeID nodeID) const {
+    return storage->get(nodeID, &Node::outgoing, &Node::hasOutgoing, [&]() {
+        auto outgoing = graph ?
+                        graph->getOutgoing(nodeID) :
+                        replay(GraphTrace::outgoing, nodeID, &GraphTrace::Contents::outgoing);
+        if (storage->trace) {
+            storage->trace->recordNeighbours(GraphTrace::outgoing, nodeID, outgoing);
+        }
+        maskNeighbours(nodeID, outgoing);
+        return outgoing;
+    });
+}
+
+std::vector<MetagraphInterface::NodeID> const &
+NodeCache::getIncoming(MetagraphInterface::NodeID nodeID) const {
+    return storage->get(nodeID, &Node::incoming, &Node::hasIncoming, [&]() {
+        auto incoming = graph ?
+                        graph->getIncoming(nodeID) :
+                        replay(GraphTrace::incoming, nodeID, &GraphTrace::Contents::incoming);
+        if (storage->trace) {
+            storage->trace->recordNeighbours(GraphTrace::incoming, nodeID, incoming);
+        }
+        maskNeighbours(nodeID, incoming);
+        return incoming;
+    });
+}
+
+std::vector<MetagraphInterface::NodeAnnotation> const &
+NodeCache::getAnnotation(MetagraphInterface::NodeID nodeID) const {
+    return storage->get(nodeID, &Node::annotations, &Node::hasAnnotations, [&]() {
+        auto annotations = graph ?
+                           graph->getAnnotation(nodeID) :
+                           replay(GraphTrace::annotation, nodeID, &GraphTrace::Contents::annotations);
+        if (storage->trace) {
+            storage->trace->recordAnnotation(nodeID, annotations);
+        }
+        return annotations;
+    });
+}
+
+std::string const & NodeCache::getKmer(MetagraphInterface::NodeID nodeID) const {
+    return storage->get(nodeID, &Node::kmer, &Node::hasKmer, [&]() {
+        auto kmer = graph ?
+                    graph->getKmer(nodeID) :
+                    replay(GraphTrace::kmer, nodeID, &GraphTrace::Contents::kmers);
+        if (storage->trace) {
+            storage->trace->recordKmer(nodeID, kmer);
+        }
+        return kmer;
+    });
+}
+
+void NodeCache::maskNeighbours(MetagraphInterface::NodeID nodeID,
+                               std::vector<MetagraphInterface::NodeID> & neighbours) const {
+    auto const & mask = storage->repeatMask;
+    if (!mask) {
+        return;
+    }
+    size_t nNeighbours = neighbours.size();
+    if (storage->repeatPolicy == RepeatMask::stop) {
+        if (mask->contains(nodeID)) {
+            neighbours.clear();
+        }
+    }
+    else {
+        neighbours.erase(std::remove_if(neighbours.begin(), neighbours.end(),
+                                        [&mask](MetagraphInterface::NodeID neighbour) {
+                                            return mask->contains(neighbour);
+                                        }),
+                         neighbours.end());
+    }
+    std::lock_guard<std::mutex> lock(storage->mutex);
+    storage->nMaskedNeighbours += nNeighbours - neighbours.size();
+}
+
+void NodeCache::setRepeatMask(std::shared_ptr<RepeatMask const> mask, RepeatMask::Policy policy) {
+    clear();
+    storage->repeatMask = mask;
+    storage->repeatPolicy = policy;
+}
+
+// the replay is compared with the queries of the trace position by position
+template <typename T>
+T const & NodeCache::replay(GraphTrace::Query query,
+                            MetagraphInterface::NodeID nodeID,
+                            std::unordered_map<MetagraphInterface::NodeID, T> GraphTrace::Contents::* responses) const {
+    static char const * const queryNames[] = {"getOutgoing", "getIncoming", "getAnnotation", "getKmer"};
+    auto const & trace = storage->replayed;
+    if (!trace) {
+        std::cout << queryNames[query] << "(" << nodeID << ") without graph or trace" << '\n';
+        exit(1);
+    }
+    auto const & recorded = (*trace).*responses;
+    auto found = recorded.find(nodeID);
+    if (found == recorded.end()) {
+        std::cout << queryNames[query] << "(" << nodeID << ") is not in the trace" << '\n';
+        exit(1);
+    }
+    std::lock_guard<std::mutex> lock(storage->mutex);
+    size_t position = storage->nReplayedQueries++;
+    if (position >= trace->queries.size() || trace->queries[position] != std::make_pair(query, nodeID)) {
+        storage->nReplayMismatches++;
+    }
+    return found->second;
+}
+
+ColorClasses::NodeColors const & NodeCache::getColors(MetagraphInterface::NodeID nodeID) const {
+    return storage->get(nodeID, &Node::colors, &Node::hasColors,
+                        [&]() { return ColorClasses::nodeColors(getAnnotation(nodeID)); });
+}
+
+void NodeCache::clear() {
+    waitForAllPrefetches();
+    std::lock_guard<std::mutex> lock(storage->mutex);
+    storage->nodes.clear();
+}
+
+void NodeCache::trim() {
+    if (size() > storage->capacity) {
+        clear();
+    }
+}
+
+void NodeCache::prefetch(std::vector<MetagraphInterface::NodeID> nodeIDs, bool upStream) const {
+    if (!storage->prefetching) {
+        return;
+    }
+    waitForPrefetch();
+    if (nodeIDs.size() > storage->prefetchLimit) {
+        nodeIDs.resize(storage->prefetchLimit);
+    }
+    // a copy that shares the cached nodes, but not the ownership of storage,
+    // bc storage owns the future that owns this copy
+    NodeCache cache;
+    cache.graph = graph;
+    cache.storage = std::shared_ptr<Storage>(storage.get(), [](Storage *) {});
+    if (storage->pendingPrefetches.size() <= prefetchSlot) {
+        storage->pendingPrefetches.resize(prefetchSlot + 1);
+    }
+    storage->pendingPrefetches[prefetchSlot] = std::async(std::launch::async, [cache, nodeIDs, upStream]() {
+        for (auto nodeID : nodeIDs) {
+            auto const & neighbours = upStream ?
+                                      cache.getIncoming(nodeID) :
+                                      cache.getOutgoing(nodeID);
+            for (auto neighbour : neighbours) {
+                cache.getColors(neighbour);
+                cache.getKmer(neighbour);
+            }
+        }
+    });
+}
+
+void NodeCache::waitForPrefetch() const {
+    if (prefetchSlot < storage->pendingPrefetches.size() &&
+        storage->pendingPrefetches[prefetchSlot].valid()) {
+        storage->pendingPrefetches[prefetchSlot].wait();
+    }
+}
+
+void NodeCache::waitForAllPrefetches() const {
+    for (auto & pendingPrefetch : storage->pendingPrefetches) {
+        if (pendingPrefetch.valid()) {
+            pendingPrefetch.wait();
+        }
+    }
+}
+
+void NodeCache::record(std::string const & path) {
+    clear();
+    storage->trace = std::make_shared<GraphTrace>(path, k, numNodes(), storage->capacity);
+}
+
+void NodeCache::stopRecording() {
+    waitForAllPrefetches();
+    if (storage->trace) {
+        storage->trace->flush();
+        storage->trace = nullptr;
+    }
+}
+
+NodeCache NodeCache::fromTrace(std::string const & path) {
+    auto contents = std::make_shared<GraphTrace::Contents>();
+    if (!GraphTrace::read(path, *contents)) {
+        exit(1);
+    }
+    NodeCache cache;
+    cache.k = contents->k;
+    cache.storage->replayed = contents;
+    cache.storage->capacity = contents->capacity;
+    return cache;
+}
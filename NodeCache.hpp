@@ -0,0 +1,227 @@
+#ifndef _NODECACHE_HPP_
+#define _NODECACHE_HPP_
+
+#include "MetagraphInterface.h"
+#include "ColorClasses.hpp"
+#include "GraphTrace.hpp"
+#include "RepeatMask.hpp"
+
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*! Wraps the MetagraphInterface and keeps the neighbours, annotations and kmer
+* of every queried node, so that each node is fetched from the graph only once.
+* \details Copies of a NodeCache share the cached nodes. Therefore several
+* SeedExtension s can extend their seeds over one shared frontier (see MultiSeedExtension).
+* References returned by the getters stay valid until clear() or trim() is called,
+* so these must only be called between extension steps.
+* The getters are thread safe. If prefetching is enabled, prefetch() fetches the
+* neighbours of a frontier in a background thread, which requires that the
+* const member functions of MetagraphInterface can be called concurrently.
+*/
+class NodeCache {
+public:
+    //! everything that was queried about a node so far
+    struct Node {
+        std::vector<MetagraphInterface::NodeID> outgoing;
+        std::vector<MetagraphInterface::NodeID> incoming;
+        std::vector<MetagraphInterface::NodeAnnotation> annotations;
+        std::string kmer;
+        ColorClasses::NodeColors colors;
+        bool hasOutgoing = false;
+        bool hasIncoming = false;
+        bool hasAnnotations = false;
+        bool hasKmer = false;
+        bool hasColors = false;
+    };
+
+    NodeCache():graph{},
+                storage{std::make_shared<Storage>()},
+                k{0} {}
+
+    //! caches the queries to graph_, trim() keeps at most capacity nodes
+    /*! explicit with the capacity, so every caller decides how many nodes it holds,
+     * e.g. defaultCapacity for the shared frontier of a MultiSeedExtension
+     */
+    explicit NodeCache(std::shared_ptr<MetagraphInterface const> graph_, size_t capacity):
+              graph{graph_},
+              storage{std::make_shared<Storage>()},
+              k{graph_ ? graph_->getK() : 0} {
+        storage->capacity = capacity;
+    }
+
+    //! a capacity for the frontier of a group of seeds that are extended in lockstep
+    static constexpr size_t defaultCapacity = 100000;
+
+    std::vector<MetagraphInterface::NodeID> const & getOutgoing(MetagraphInterface::NodeID nodeID) const;
+    std::vector<MetagraphInterface::NodeID> const & getIncoming(MetagraphInterface::NodeID nodeID) const;
+    std::vector<MetagraphInterface::NodeAnnotation> const & getAnnotation(MetagraphInterface::NodeID nodeID) const;
+    std::string const & getKmer(MetagraphInterface::NodeID nodeID) const;
+    //! returns the annotations of the node in interned form (see ColorClasses)
+    ColorClasses::NodeColors const & getColors(MetagraphInterface::NodeID nodeID) const;
+
+    size_t getK() const {
+        return k;
+    }
+    size_t numNodes() const {
+        return graph ? graph->numNodes() : storage->replayed ? storage->replayed->numNodes : 0;
+    }
+
+    //! number of nodes in the cache
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(storage->mutex);
+        return storage->nodes.size();
+    }
+    //! number of queries that were answered from the cache
+    size_t nHits() const {
+        std::lock_guard<std::mutex> lock(storage->mutex);
+        return storage->nHits;
+    }
+    //! number of queries that were fetched from the graph
+    size_t nMisses() const {
+        std::lock_guard<std::mutex> lock(storage->mutex);
+        return storage->nMisses;
+    }
+    //! maximal number of nodes kept by trim()
+    void setCapacity(size_t capacity) {
+        storage->capacity = capacity;
+    }
+    //! removes all nodes from the cache
+    void clear();
+    //! clears the cache if it holds more nodes than its capacity
+    void trim();
+
+    //! enables or disables prefetch()
+    void setPrefetching(bool prefetching, size_t prefetchLimit = 64) {
+        storage->prefetching = prefetching;
+        storage->prefetchLimit = prefetchLimit;
+    }
+    bool isPrefetching() const {
+        return storage->prefetching;
+    }
+    //! fetches the neighbours (in extension direction) of nodeIDs with their annotations and kmers in the background
+    /*! nodeIDs should be sorted by priority, only the first prefetchLimit nodes are considered
+     * does nothing if prefetching is disabled
+     */
+    void prefetch(std::vector<MetagraphInterface::NodeID> nodeIDs, bool upStream) const;
+    //! blocks until the running prefetch() of the prefetch slot of this copy is done
+    /*! prefetch() and waitForPrefetch() must be called from one thread only */
+    void waitForPrefetch() const;
+    //! blocks until the running prefetch() of every slot is done
+    void waitForAllPrefetches() const;
+    //! returns a copy that shares the cached nodes, but prefetches in its own slot
+    /*! A prefetch() only waits for the previous one of the same slot. So if every
+     * seed of a group has its own slot (see MultiSeedExtension), the neighbours of
+     * the frontiers of all seeds are fetched at the same time, while the seeds are
+     * extended one after another.
+     */
+    NodeCache withPrefetchSlot(size_t slot) const {
+        NodeCache copy = *this;
+        copy.prefetchSlot = slot;
+        return copy;
+    }
+
+    //! hides the repeat nodes of mask from the extension according to policy, see RepeatMask::Policy
+    /*! the neighbours are filtered when they are fetched, so the cache is cleared.
+     * The trace (see record()) holds the unfiltered neighbours.
+     */
+    void setRepeatMask(std::shared_ptr<RepeatMask const> mask, RepeatMask::Policy policy);
+    //! nullptr if no repeat mask is set
+    std::shared_ptr<RepeatMask const> repeatMask() const {
+        return storage->repeatMask;
+    }
+    RepeatMask::Policy repeatPolicy() const {
+        return storage->repeatPolicy;
+    }
+    //! returns true if the repeat mask says that nodeID must not be part of an extension
+    bool isSkipped(MetagraphInterface::NodeID nodeID) const {
+        return storage->repeatMask &&
+               storage->repeatPolicy == RepeatMask::skip &&
+               storage->repeatMask->contains(nodeID);
+    }
+    //! number of neighbours that were hidden by the repeat mask
+    size_t nMaskedNeighbours() const {
+        std::lock_guard<std::mutex> lock(storage->mutex);
+        return storage->nMaskedNeighbours;
+    }
+
+    //! records every query to graph and its response in a GraphTrace at path
+    /*! the cache is cleared first, so that every node that is used is in the trace.
+     * The capacity is stored in the trace, so it has to be set before.
+     * A cache that replays a trace can record as well, e.g. with another capacity.
+     */
+    void record(std::string const & path);
+    //! stops recording and writes the trace to its file
+    void stopRecording();
+    //! returns a NodeCache without graph that answers its misses from the trace at path
+    /*! It caches, trims and clears like a NodeCache of a graph with the capacity of
+     * the recorded run, so a run with the order of seeds of the recorded run makes
+     * the same queries (see nReplayMismatches()). A query that is not in the trace at
+     * all is a fatal error.
+     * exits if the trace cannot be read
+     */
+    static NodeCache fromTrace(std::string const & path);
+    //! number of queries of a replay that differ from the query at the same position of the trace
+    /*! 0 if the replay made the recorded queries in the recorded order. Prefetching
+     * makes the order of the queries vary from run to run.
+     */
+    size_t nReplayMismatches() const {
+        std::lock_guard<std::mutex> lock(storage->mutex);
+        return storage->nReplayMismatches;
+    }
+
+    std::shared_ptr<MetagraphInterface const> graph;
+
+private:
+    //! removes the neighbours of nodeID that are hidden by the repeat mask
+    void maskNeighbours(MetagraphInterface::NodeID nodeID,
+                        std::vector<MetagraphInterface::NodeID> & neighbours) const;
+    //! returns the response of the replayed trace to query of nodeID, exits if it is not in the trace
+    template <typename T>
+    T const & replay(GraphTrace::Query query,
+                     MetagraphInterface::NodeID nodeID,
+                     std::unordered_map<MetagraphInterface::NodeID, T> GraphTrace::Contents::* responses) const;
+
+    //! shared by all copies of a NodeCache
+    struct Storage {
+        //! returns the cached (node.*value), calls fetch() first if (node.*has) is false
+        template <typename T, typename Fetch>
+        T const & get(MetagraphInterface::NodeID nodeID,
+                      T Node::* value,
+                      bool Node::* has,
+                      Fetch fetch);
+
+        std::unordered_map<MetagraphInterface::NodeID, Node> nodes;
+        size_t capacity = defaultCapacity;
+        std::mutex mutex;
+        // cache statistics over all queries, incl. the ones made by prefetch()
+        size_t nHits = 0;
+        size_t nMisses = 0;
+        bool prefetching = false;
+        size_t prefetchLimit = 64;
+        //! the queries to graph are recorded here, if not nullptr
+        std::shared_ptr<GraphTrace> trace;
+        //! the trace that answers the misses if there is no graph, see fromTrace()
+        std::shared_ptr<GraphTrace::Contents const> replayed;
+        //! number of misses answered from replayed
+        size_t nReplayedQueries = 0;
+        size_t nReplayMismatches = 0;
+        std::shared_ptr<RepeatMask const> repeatMask;
+        RepeatMask::Policy repeatPolicy = RepeatMask::skip;
+        size_t nMaskedNeighbours = 0;
+        // declared last, so a running prefetch is finished before nodes is destroyed
+        //! the running prefetch() of every slot
+        std::vector<std::future<void>> pendingPrefetches;
+    };
+
+    std::shared_ptr<Storage> storage;
+    size_t k;
+    //! index into Storage::pendingPrefetches, see withPrefetchSlot()
+    size_t prefetchSlot = 0;
+};
+
+#endif //_NODECACHE_HPP_
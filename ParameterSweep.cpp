@@ -0,0 +1,127 @@
+#include "ParameterSweep.hpp"
+
+#include "ColorClasses.hpp"
+#include "ExtensionResult.hpp"
+#include "MultiSeedExtension.hpp"
+#include "SeedExtension.hpp"
+
+#include <chrono>
+#include <map>
+#include <utility>
+#include <vector>
+
+std::vector<std::vector<ExtensionResult>>
+ParameterSweep::run(std::vector<MultiSeedExtension::Seed> const & seeds) {
+    std::vector<std::vector<ExtensionResult>> results(parameters.size(),
+                                                      std::vector<ExtensionResult>(seeds.size()));
+    // the binsize changes the bundles from the first step on, so there is nothing to share
+    std::map<size_t, std::vector<size_t>> parametersOfBinsize;
+    for (size_t p = 0; p < parameters.size(); p++) {
+        parametersOfBinsize[parameters[p].binsize].push_back(p);
+    }
+    for (auto const & binsizeParameters : parametersOfBinsize) {
+        for (size_t i = 0; i < seeds.size(); i++) {
+            extendSeed(seeds, i, binsizeParameters.second, results);
+        }
+    }
+    return results;
+}
+
+void ParameterSweep::extendSeed(std::vector<MultiSeedExtension::Seed> const & seeds,
+                                size_t seedIndex,
+                                std::vector<size_t> const & parameterIndices,
+                                std::vector<std::vector<ExtensionResult>> & results) {
+    if (parameterIndices.empty()) {
+        return;
+    }
+    // the xdrop of the extension is not used, every branch decides with the xdrop of its parameters
+    SeedExtension extension(graph, parameters[parameterIndices[0]].xdrop,
+                            parameters[parameterIndices[0]].binsize);
+    MultiSeedExtension::initSeed(extension, seeds[seedIndex], idMap);
+    std::vector<Branch> branches{Branch{extension, parameterIndices, true}};
+
+    // same order as SeedExtension::extend(): first downStream, then upStream
+    for (bool upStream : {false, true}) {
+        for (auto & branch : branches) {
+            branch.active = true;
+        }
+        bool anyActive = true;
+        while (anyActive) {
+            anyActive = false;
+            // branches that are added in this round made their step already
+            size_t nBranchesBefore = branches.size();
+            for (size_t b = 0; b < nBranchesBefore; b++) {
+                if (branches[b].active) {
+                    branches[b].active = extendOneStep(branches, b, upStream);
+                    anyActive = anyActive || branches[b].active;
+                }
+            }
+            graph.trim();
+        }
+    }
+    nBranches += branches.size();
+    for (auto const & branch : branches) {
+        for (auto p : branch.parameterIndices) {
+            results[p][seedIndex] = ExtensionResult(seedIndex, branch.extension);
+        }
+    }
+}
+
+bool ParameterSweep::extendOneStep(std::vector<Branch> & branches, size_t b, bool upStream) {
+    // branches may grow, so branches[b] is accessed by index
+    auto tipsHis = [&](size_t i) -> std::vector<std::shared_ptr<AllTips>> & {
+        return upStream ? branches[i].extension.upStreamTipsHistory : branches[i].extension.tipsHistory;
+    };
+    // parameters whose extension in this direction is finished keep the current state
+    std::vector<size_t> finished, continuing;
+    for (auto p : branches[b].parameterIndices) {
+        bool canExtend = branches[b].extension.canExtend(parameters[p].sufficientMaxScore, tipsHis(b));
+        (canExtend ? continuing : finished).push_back(p);
+    }
+    if (continuing.empty()) {
+        return false;
+    }
+    if (!finished.empty()) {
+        branches.push_back(Branch{branches[b].extension, finished, false});
+        branches[b].parameterIndices = continuing;
+    }
+
+    auto stepStart = std::chrono::steady_clock::now();
+    branches[b].extension.extendWithoutXDrop(tipsHis(b), upStream);
+    nSteps++;
+
+    // the decision only depends on xdrop, parameters that decide the same share a branch
+    std::map<uint64_t, std::pair<size_t, std::vector<ColorClasses::AnnoKey>>> decisionOfXdrop;
+    std::vector<std::pair<std::pair<size_t, std::vector<ColorClasses::AnnoKey>>, std::vector<size_t>>> decisions;
+    for (auto p : continuing) {
+        auto found = decisionOfXdrop.find(parameters[p].xdrop);
+        if (found == decisionOfXdrop.end()) {
+            std::vector<ColorClasses::AnnoKey> annosToBeDropped;
+            size_t goBackTo = branches[b].extension.decideXDrop(parameters[p].xdrop,
+                                                                tipsHis(b).back(),
+                                                                annosToBeDropped);
+            found = decisionOfXdrop.insert({parameters[p].xdrop, {goBackTo, annosToBeDropped}}).first;
+        }
+        size_t d = 0;
+        while (d < decisions.size() && decisions[d].first != found->second) {
+            d++;
+        }
+        if (d == decisions.size()) {
+            decisions.push_back({found->second, {}});
+        }
+        decisions[d].second.push_back(p);
+    }
+
+    // the new branches are copied before branches[b] applies its decision
+    for (size_t d = 1; d < decisions.size(); d++) {
+        branches.push_back(Branch{branches[b].extension, decisions[d].second, true});
+    }
+    size_t firstNewBranch = branches.size() - (decisions.size() - 1);
+    branches[b].parameterIndices = decisions[0].second;
+    for (size_t d = 0; d < decisions.size(); d++) {
+        size_t i = d == 0 ? b : firstNewBranch + d - 1;
+        branches[i].extension.applyXDrop(tipsHis(i), upStream, decisions[d].first.first, decisions[d].first.second);
+        branches[i].extension.finishStep(stepStart, tipsHis(i));
+    }
+    return true;
+}
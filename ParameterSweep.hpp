@@ -0,0 +1,72 @@
+#ifndef _ParameterSweep_HPP_
+#define _ParameterSweep_HPP_
+
+#include "ExtensionResult.hpp"
+#include "IdentifierMapping.h"
+#include "MultiSeedExtension.hpp"
+#include "NodeCache.hpp"
+#include "SeedExtension.hpp"
+
+#include <memory>
+#include <vector>
+
+/* Extends every seed once for several settings of xdrop, sufficientMaxScore and binsize
+* \details The settings with the same binsize share one traversal of the graph. A seed
+* is extended step by step like in SeedExtension::extendOneStep(), and its state is
+* copied into a new branch only when the settings of a branch disagree, i.e. when some
+* of them stop (see SeedExtension::canExtend()) or when xDrop drops different annos
+* (see SeedExtension::decideXDrop()). Branches share their history up to that point.
+* The result of every setting is identical to a separate run with this setting
+* (without fast forward and budgets, which are not supported here).
+*/
+class ParameterSweep {
+
+public:
+    //! one setting of the sweep
+    struct Parameters {
+        uint64_t xdrop;
+        size_t sufficientMaxScore;
+        size_t binsize;
+    };
+
+    ParameterSweep(NodeCache graph_,
+                   std::shared_ptr<IdentifierMapping const> idMap_,
+                   std::vector<Parameters> parameters_):
+                   graph{graph_},
+                   idMap{idMap_},
+                   parameters{parameters_} {}
+
+    //! extends all seeds, returns the result of seeds[i] with parameters[p] at [p][i]
+    std::vector<std::vector<ExtensionResult>> run(std::vector<MultiSeedExtension::Seed> const & seeds);
+    //! extends seeds[seedIndex] for the parameters with the indices in parameterIndices
+    /*! they must have the same binsize, the results are written to results[p][seedIndex] */
+    void extendSeed(std::vector<MultiSeedExtension::Seed> const & seeds,
+                    size_t seedIndex,
+                    std::vector<size_t> const & parameterIndices,
+                    std::vector<std::vector<ExtensionResult>> & results);
+
+    //! shared by all seeds and parameters
+    NodeCache graph;
+    std::shared_ptr<IdentifierMapping const> idMap;
+    std::vector<Parameters> parameters;
+
+    // for sweep analysis
+    //! number of branches of all seeds, a run per setting would need parameters.size() per seed
+    size_t nBranches = 0;
+    //! number of extension steps made by all branches
+    size_t nSteps = 0;
+
+private:
+    //! the state of a seed that is shared by some parameters
+    struct Branch {
+        SeedExtension extension;
+        std::vector<size_t> parameterIndices;
+        //! false if the extension in the current direction is finished
+        bool active;
+    };
+    //! makes one step of branches[b] and adds branches for parameters that disagree
+    /*! returns false if no step was made */
+    bool extendOneStep(std::vector<Branch> & branches, size_t b, bool upStream);
+};
+
+#endif //_ParameterSweep_HPP_
@@ -1,13 +1,19 @@
 #include "PathBundleTip.hpp"
 
 #include "MetagraphInterface.h"
+#include "ColorClasses.hpp"
+#include "NodeCache.hpp"
 
+#include <algorithm>
+#include <limits>
 #include <vector>
 #include <memory>
+#include <string>
+#include <utility>
 
 //! extends every annotation in current bundle
 std::vector<std::shared_ptr<PathBundleTip>>
-PathBundleTip::extendTip(std::shared_ptr <MetagraphInterface const> graph,
+PathBundleTip::extendTip(NodeCache const & graph,
                          bool upStream,
                          size_t binsize_,
                          uint64_t numberOfExtensionsMade) {
@@ -16,22 +22,32 @@ PathBundleTip::extendTip(std::shared_ptr <MetagraphInterface const> graph,
     // bundles of each outgoing node, which has at least one continuing  annotation
     std::vector<std::shared_ptr<PathBundleTip>> outgoingTips;
 
-    std::vector<long unsigned int> outgoing_ids;
-    if (!upStream) outgoing_ids = graph->getOutgoing(nodeID);
-    else outgoing_ids = graph->getIncoming(nodeID);
+    auto const & outgoing_ids = upStream ?
+                                graph.getIncoming(nodeID) :
+                                graph.getOutgoing(nodeID);
+    // the annotations of this bundle are a subset of the annotations of its node
+    auto const & currentColors = graph.getColors(nodeID);
 
     // loop through new nodes: max 4 different
     for (auto out_id : outgoing_ids) {
-        auto outgoingNodeAnnotations = graph->getAnnotation(out_id);
+        auto const & outgoingColors = graph.getColors(out_id);
+        // an annotation whose track the current node doesnt have cannot continue
+        auto const & sharedTracks = ColorClasses::sharedTracks(currentColors.colorClass,
+                                                               outgoingColors.colorClass);
         auto outgoingTip = std::make_shared<PathBundleTip>(PathBundleTip{});
         // loop through annotations of new node
-        for (MetagraphInterface::NodeAnnotation & outgoingNodeAnnotation : outgoingNodeAnnotations) {
+        for (size_t i = 0; i < outgoingColors.annotations.size(); ++i) {
+            if (!sharedTracks[outgoingColors.trackIndices[i]]) {
+                continue;
+            }
+            auto const & outgoingNodeAnnotation = outgoingColors.annotations[i];
             // look for the outgoingNodeAnnotation in the current PathBundleTip
             auto matchingAnno = annotations.find(outgoingNodeAnnotation);
             unsigned latestTransition;
 
             if (matchingAnno != annotations.end()) {
                 latestTransition = matchingAnno->second.latestTransition;
+                // the scores are copied as they are, the new bundle takes over the pending offset
                 outgoingTip->annotations.insert({outgoingNodeAnnotation,
                                               {matchingAnno->second.currentScore,
                                                matchingAnno->second.maxScore,
@@ -47,9 +63,9 @@ PathBundleTip::extendTip(std::shared_ptr <MetagraphInterface const> graph,
             if (modifiedBinIdxIsGreater0) {
                 // look for outgoingNodeAnnotation in current tip
                 // with modified bin_idx
-                outgoingNodeAnnotation.bin_idx -= binsize;
-                matchingAnno = annotations.find(outgoingNodeAnnotation);
-                outgoingNodeAnnotation.bin_idx += binsize; //undo modification
+                auto neighbouringBinAnnotation = outgoingNodeAnnotation;
+                neighbouringBinAnnotation.bin_idx -= binsize;
+                matchingAnno = annotations.find(neighbouringBinAnnotation);
 
                 if (matchingAnno != annotations.end()) {
                     // found annotation in neighbouring bin_idx
@@ -75,16 +91,88 @@ PathBundleTip::extendTip(std::shared_ptr <MetagraphInterface const> graph,
         // new PathBundleTip for that node
         if (outgoingTip->annotations.size() > 0){
             outgoingTip->nodeID = out_id;
+            outgoingTip->scoreOffset = scoreOffset;
+            outgoingTip->maxScoreOffset = maxScoreOffset;
+            outgoingTip->ageOfMaxScoreOffset = ageOfMaxScoreOffset;
+            outgoingTip->maxScoreGap = maxScoreGap;
             outgoingTips.push_back(outgoingTip);
         }
     }
     return outgoingTips;
 }
 
-void  PathBundleTip::print(std::shared_ptr<MetagraphInterface const> graph) const {
-    for (auto & [metaAnno, annoScore] : annotations){
-        std::cout<< graph->getKmer(nodeID)
-                 << metaAnno.genome << " "
+// mirrors the matching in extendTip()
+bool PathBundleTip::continuesUnchanged(NodeCache const & graph,
+                                       bool upStream,
+                                       size_t binsize_,
+                                       uint64_t numberOfExtensionsMade,
+                                       MetagraphInterface::NodeID & outID) const {
+    const int binsize = upStream ? - binsize_ : binsize_;
+    auto const & outgoing_ids = upStream ?
+                                graph.getIncoming(nodeID) :
+                                graph.getOutgoing(nodeID);
+    if (outgoing_ids.size() != 1) {
+        return false;
+    }
+    auto const & outgoingColors = graph.getColors(outgoing_ids.front());
+    auto const & sharedTracks = ColorClasses::sharedTracks(graph.getColors(nodeID).colorClass,
+                                                           outgoingColors.colorClass);
+    size_t nContinuingAnnotations = 0;
+    for (size_t i = 0; i < outgoingColors.annotations.size(); ++i) {
+        if (!sharedTracks[outgoingColors.trackIndices[i]]) {
+            continue;
+        }
+        auto const & outgoingNodeAnnotation = outgoingColors.annotations[i];
+        if (annotations.find(outgoingNodeAnnotation) != annotations.end()) {
+            nContinuingAnnotations++;
+            continue;
+        }
+        bool modifiedBinIdxIsGreater0 = upStream ?
+                                        true :
+                                        binsize_ <= outgoingNodeAnnotation.bin_idx;
+        if (modifiedBinIdxIsGreater0) {
+            auto neighbouringBinAnnotation = outgoingNodeAnnotation;
+            neighbouringBinAnnotation.bin_idx -= binsize;
+            auto matchingAnno = annotations.find(neighbouringBinAnnotation);
+            if (matchingAnno != annotations.end() &&
+                (matchingAnno->second.latestTransition == 0 ||
+                 numberOfExtensionsMade + 1 - matchingAnno->second.latestTransition >= binsize_)) {
+                // this anno would make a bin_idx transition
+                return false;
+            }
+        }
+    }
+    outID = outgoing_ids.front();
+    return nContinuingAnnotations == annotations.size();
+}
+
+void PathBundleTip::materializeScores() {
+    bool nothingPending = scoreOffset == 0 && maxScoreOffset == -std::numeric_limits<double>::infinity();
+    if (nothingPending) {
+        return;
+    }
+    maxScoreGap = 0;
+    for (auto & [metaAnno, annoScore] : annotations) {
+        annoScore = effectiveScore(annoScore);
+        maxScoreGap = std::max(maxScoreGap, annoScore.maxScore - annoScore.currentScore);
+    }
+    scoreOffset = 0;
+    maxScoreOffset = -std::numeric_limits<double>::infinity();
+    ageOfMaxScoreOffset = 0;
+}
+// an annotation is dropped if currentScore + scoreOffset < max(maxScore, currentScore + maxScoreOffset) - xdrop
+// i.e. if scoreOffset < max(maxScore - currentScore, maxScoreOffset) - xdrop
+bool PathBundleTip::cannotBeDropped(uint64_t xdrop) const {
+    // tolerance for rounding, when in doubt the annotations are checked one by one
+    double const tolerance = 1e-6;
+    return(scoreOffset >= std::max(maxScoreGap, maxScoreOffset) - xdrop + tolerance);
+}
+
+void  PathBundleTip::print(NodeCache const & graph) const {
+    for (auto & [metaAnno, scoreWithoutOffset] : annotations){
+        auto annoScore = effectiveScore(scoreWithoutOffset);
+        std::cout<< graph.getKmer(nodeID)
+                 << ColorClasses::track(metaAnno.track).genome << " "
                  << metaAnno.bin_idx << " "
                  << annoScore.currentScore << " "
                  << annoScore.maxScore << std::endl;
@@ -92,8 +180,9 @@ void  PathBundleTip::print(std::shared_ptr<MetagraphInterface const> graph) cons
 }
 
 void  PathBundleTip::print() const{
-    for (auto & [metaAnno, annoScore] : annotations){
-        std::cout << metaAnno.genome <<" "
+    for (auto & [metaAnno, scoreWithoutOffset] : annotations){
+        auto annoScore = effectiveScore(scoreWithoutOffset);
+        std::cout << ColorClasses::track(metaAnno.track).genome <<" "
                   << metaAnno.bin_idx <<" "
                   << annoScore.currentScore <<" "
                   << annoScore.maxScore << std::endl;
@@ -105,3 +194,12 @@ void PathBundleTip::printMetaAnno(MetagraphInterface::NodeAnnotation const & ann
               << anno.reverse_strand << ", "
               << anno.bin_idx <<  '\n';
 }
+
+size_t PathBundleTip::memoryUsage() const {
+    // a node of an unordered_map holds the value, a pointer to the next node and the hash
+    // the strings of the annotations are shared by all bundles (see ColorClasses)
+    size_t nodeSize = sizeof(void*) + sizeof(std::pair<ColorClasses::AnnoKey const, Score>) + sizeof(size_t);
+    return sizeof(PathBundleTip)
+         + annotations.bucket_count() * sizeof(void*)
+         + annotations.size() * nodeSize;
+}
@@ -2,7 +2,10 @@
 #define _PATHBUNDLETIP_HPP_
 
 #include "MetagraphInterface.h"
+#include "ColorClasses.hpp"
+#include "NodeCache.hpp"
 
+#include <limits>
 #include <vector>
 #include <memory>
 
@@ -10,9 +13,15 @@
 /*! Represents all annotations of a metagraph node
 * which are considered in the current seed extension.
 * \details Each annotation is a tuple of metagraph annotation and Score.
+* The metagraph annotation is stored in interned form (ColorClasses::AnnoKey).
 * Every annotation a_ has its own score, since we want to drop a_ in xDrop
 * if a_ doenst match well to all the other annotations
 * (Knoten v, Buendel B(v))
+* \details All annotations of a bundle get the same score in an extension step.
+* Therefore the scores are updated lazily: the bundle accumulates the deltas in
+* scoreOffset and the annotations keep the Score they had when the offset was
+* last applied. effectiveScore() returns the actual Score of an annotation,
+* materializeScores() writes the offset into the annotations.
 */
 class PathBundleTip{
 
@@ -43,38 +52,88 @@ public:
         }
     };
 
+    using annotationsMapType = std::unordered_map<ColorClasses::AnnoKey,
+                                                  Score,
+                                                  ColorClasses::HashAnnoKey>;
+
     PathBundleTip(uint64_t nodeId_,
-                  std::unordered_map<MetagraphInterface::NodeAnnotation,
-                                     Score,
-                                     HashNodeAnnotation> annotations_):
+                  annotationsMapType annotations_):
                   nodeID{nodeId_},
                   annotations{annotations_}{}
 
     PathBundleTip():nodeID{0},annotations{}{}
 
+    //! returns the actual Score of an annotation of this bundle
+    Score effectiveScore(Score const & score) const {
+        Score actualScore = score;
+        actualScore.currentScore += scoreOffset;
+        // the max of the currentScore since the offset was last applied
+        double maxCurrentScore = score.currentScore + maxScoreOffset;
+        if (actualScore.maxScore <= maxCurrentScore) {
+            actualScore.maxScore = maxCurrentScore;
+            actualScore.ageOfMaxScore = ageOfMaxScoreOffset;
+        }
+        return actualScore;
+    }
+    //! adds delta to the currentScore of all annotations
+    void addToScores(double delta) {
+        scoreOffset += delta;
+    }
+    //! sets the maxScore of all annotations whose currentScore reached it
+    void updateMaxScores(uint64_t numberOfExtensionsMade) {
+        if (maxScoreOffset <= scoreOffset) {
+            maxScoreOffset = scoreOffset;
+            ageOfMaxScoreOffset = numberOfExtensionsMade;
+        }
+    }
+    //! applies the pending offset to the Score of every annotation
+    void materializeScores();
+    //! true if no annotation can have currentScore < maxScore - xdrop
+    bool cannotBeDropped(uint64_t xdrop) const;
+
     /*! searches in adjacent nodes, whether the sequence corresponding to
     * a current annotation continues
     */
-    std::vector<std::shared_ptr<PathBundleTip>> extendTip(std::shared_ptr<MetagraphInterface const>  graph,
+    std::vector<std::shared_ptr<PathBundleTip>> extendTip(NodeCache const & graph,
                                          bool upStream,
                                          size_t binsize,
                                          uint64_t numberOfExtensionsMade);
 
-    void print(std::shared_ptr<MetagraphInterface const>  graph) const;
+    //! returns true if extendTip() would return only one bundle with node outID and the same annotations and Score s
+    /*! i.e. outID is the only neighbour and every annotation continues without a bin_idx transition
+     */
+    bool continuesUnchanged(NodeCache const & graph,
+                            bool upStream,
+                            size_t binsize,
+                            uint64_t numberOfExtensionsMade,
+                            MetagraphInterface::NodeID & outID) const;
+
+    void print(NodeCache const & graph) const;
 
     void print() const; // without kmer
 
     static void printMetaAnno(MetagraphInterface::NodeAnnotation const & anno);
 
+    //! returns the number of bytes allocated for this bundle (incl. its annotations)
+    size_t memoryUsage() const;
+
     bool operator==(PathBundleTip const & other) const{
         return (nodeID == other.nodeID);
     }
 
     uint64_t nodeID;
     // all annotations for this bundle
-    std::unordered_map<MetagraphInterface::NodeAnnotation,
-                       Score,
-                       HashNodeAnnotation> annotations;
+    annotationsMapType annotations;
+
+    // lazy score update
+    //! not yet applied delta of the currentScore of all annotations
+    double scoreOffset = 0;
+    //! max of scoreOffset since it was last applied, -inf if no step was made since then
+    double maxScoreOffset = -std::numeric_limits<double>::infinity();
+    //! the extension step in which maxScoreOffset was set
+    uint64_t ageOfMaxScoreOffset = 0;
+    //! upper bound of maxScore - currentScore of the stored Score s
+    double maxScoreGap = 0;
 
 };
 #endif //_PATHBUNDLETIP_HPP_
@@ -0,0 +1,88 @@
+#include "RepeatMask.hpp"
+
+#include "MetagraphInterface.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+constexpr char RepeatMask::magic[8];
+
+bool RepeatMask::build(MetagraphInterface const & graph,
+                       size_t maxAnnotations,
+                       size_t maxDegree,
+                       std::string const & path) {
+    // before the scan of the whole graph
+    std::ofstream outf(path, std::ios::binary);
+    if (!outf) {
+        std::cout << "cannot write repeat mask " << path << '\n';
+        return false;
+    }
+    Header header{};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.numNodes = graph.numNodes();
+    header.maxAnnotations = maxAnnotations;
+    header.maxDegree = maxDegree;
+    // node IDs start at 1, bit 0 stays unset
+    std::vector<uint64_t> bits(header.numNodes / 64 + 1, 0);
+    for (MetagraphInterface::NodeID nodeID = 1; nodeID <= header.numNodes; nodeID++) {
+        bool isRepeat = (maxAnnotations != 0 && graph.getAnnotation(nodeID).size() > maxAnnotations)
+                     || (maxDegree != 0 && (graph.getOutgoing(nodeID).size() > maxDegree ||
+                                            graph.getIncoming(nodeID).size() > maxDegree));
+        if (isRepeat) {
+            bits[nodeID / 64] |= uint64_t(1) << (nodeID % 64);
+            header.nRepeatNodes++;
+        }
+    }
+    outf.write(reinterpret_cast<char const *>(&header), sizeof(header));
+    outf.write(reinterpret_cast<char const *>(bits.data()), bits.size() * sizeof(uint64_t));
+    return(bool(outf));
+}
+
+RepeatMask::RepeatMask(std::string const & path_):path{path_},
+                                                   data{nullptr},
+                                                   fileSize{0} {
+    int fd = open(path.c_str(), O_RDONLY);
+    struct stat fileStat;
+    if (fd < 0 || fstat(fd, &fileStat) != 0) {
+        std::cout << "cannot open repeat mask " << path << '\n';
+        exit(1);
+    }
+    fileSize = fileStat.st_size;
+    if (fileSize < sizeof(Header)) {
+        std::cout << "repeat mask " << path << " is too short" << '\n';
+        exit(1);
+    }
+    data = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping stays valid
+    if (data == MAP_FAILED) {
+        std::cout << "cannot map repeat mask " << path << '\n';
+        exit(1);
+    }
+    // the extension looks up nodes all over the graph
+    madvise(data, fileSize, MADV_RANDOM);
+
+    header = static_cast<Header const *>(data);
+    bits = reinterpret_cast<uint64_t const *>(static_cast<char const *>(data) + sizeof(Header));
+    if (std::memcmp(header->magic, magic, sizeof(magic)) != 0) {
+        std::cout << path << " is not a repeat mask" << '\n';
+        exit(1);
+    }
+    if (sizeof(Header) + (header->numNodes / 64 + 1) * sizeof(uint64_t) > fileSize) {
+        std::cout << "repeat mask " << path << " is truncated" << '\n';
+        exit(1);
+    }
+}
+
+RepeatMask::~RepeatMask() {
+    if (data != nullptr) {
+        munmap(data, fileSize);
+    }
+}
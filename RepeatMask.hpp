@@ -0,0 +1,78 @@
+#ifndef _RepeatMask_HPP_
+#define _RepeatMask_HPP_
+
+#include "MetagraphInterface.h"
+
+#include <cstdint>
+#include <string>
+
+/* Bitmap of the repeat nodes of a graph, memory mapped from a file
+* \details A node is a repeat node if it has more than maxAnnotations annotations or
+* more than maxDegree incoming or outgoing neighbours. Extending through such nodes
+* pulls in a lot of unrelated annotations (see SeedExtension::tooManyAnnosInInit).
+* The file is written once per graph by build() and passed to
+* NodeCache::setRepeatMask(), which hides the repeat nodes from the extension.
+*
+* Layout (native byte order):
+*   Header
+*   uint64_t bits[(numNodes + 64) / 64]   node i is a repeat node if bit i % 64 of bits[i / 64] is set
+*/
+class RepeatMask {
+public:
+    struct Header {
+        char magic[8];
+        uint64_t numNodes;
+        //! thresholds the file was built with, 0 means not used
+        uint64_t maxAnnotations;
+        uint64_t maxDegree;
+        //! number of set bits
+        uint64_t nRepeatNodes;
+    };
+    //! how NodeCache treats repeat nodes
+    enum Policy {
+        //! repeat nodes are not entered, they are removed from the neighbours of every node
+        skip,
+        //! repeat nodes are entered, but the extension stops there, i.e. they have no neighbours
+        stop
+    };
+
+    //! determines the repeat nodes of graph and writes them to path, returns false if the file cannot be written
+    static bool build(MetagraphInterface const & graph,
+                      size_t maxAnnotations,
+                      size_t maxDegree,
+                      std::string const & path);
+
+    //! maps the file at path, exits if it is not a valid RepeatMask
+    RepeatMask(std::string const & path);
+    ~RepeatMask();
+    RepeatMask(RepeatMask const &) = delete;
+    RepeatMask & operator=(RepeatMask const &) = delete;
+
+    //! returns true if nodeID is a repeat node, false for node IDs outside of the graph
+    bool contains(MetagraphInterface::NodeID nodeID) const {
+        return nodeID <= header->numNodes && (bits[nodeID / 64] >> (nodeID % 64) & 1) != 0;
+    }
+    size_t numNodes() const {
+        return header->numNodes;
+    }
+    size_t nRepeatNodes() const {
+        return header->nRepeatNodes;
+    }
+    size_t maxAnnotations() const {
+        return header->maxAnnotations;
+    }
+    size_t maxDegree() const {
+        return header->maxDegree;
+    }
+
+    static constexpr char magic[8] = {'R', 'E', 'P', 'M', 'A', 'S', 'K', '1'};
+
+private:
+    std::string path;
+    void * data;
+    size_t fileSize;
+    Header const * header;
+    uint64_t const * bits;
+};
+
+#endif //_RepeatMask_HPP_
@@ -4,58 +4,129 @@
 #include "IdentifierMapping.h"
 #include "Link.h"
 #include "PathBundleTip.hpp"
+#include "ColorClasses.hpp"
+#include "LinearGenomes.hpp"
+#include "NodeCache.hpp"
+#include "SeedFile.hpp"
 
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <string>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 void SeedExtension::initFirstTip(std::vector<MetagraphInterface::NodeID> nodeIDs,
                                  LinkPtr link,
                                  std::shared_ptr<IdentifierMapping const> idMap_) {
     idMap = idMap_; //not in ctor, bc idMap not available in test/testSeedExtension.cpp
-    tipsHistory.clear();
-    upStreamTipsHistory.clear();
-
-    // for extension analysis
-    tooManyDeletedAnnos = 0;
-    nMerges = 0;
-    nSplits = 0;
-    tooManyAnnosInInit = 0;
-    maxUpstreamSteps = 0;
-    maxSteps = 0;
-
-    auto firstAllTips = std::make_shared<AllTips>(AllTips{});
+    referenceGenomeID = ColorClasses::genomeID(idMap->queryGenomeName(0));
+    resetExtension();
+
+    // the names are looked up once per occurrence, not once per occurrence and annotation
+    occurrenceSetType occurrences;
+    for (auto & occurrence : link->occurrence()) {
+        MetagraphInterface::NodeAnnotation anno;
+        anno.genome = idMap->queryGenomeName(occurrence.genome());
+        anno.sequence = idMap->querySequenceName(occurrence.sequence());
+        anno.reverse_strand = occurrence.reverse();
+        anno.bin_idx = occurrence.position();
+        occurrences.insert(ColorClasses::annoKey(anno));
+    }
 
     //bc nodeIDs contains ids twice, see implementation in Linkset.h
     std::unordered_set<MetagraphInterface::NodeID> nonDupNodeIDs;
     nonDupNodeIDs.insert(nodeIDs.begin(), nodeIDs.end());
 
-    for (auto nodeID : nonDupNodeIDs) {
+    initFirstTip(nonDupNodeIDs, occurrences, link->occurrence().size());
+}
+void SeedExtension::initFirstTip(SeedFile const & seedFile,
+                                 size_t seedIndex,
+                                 std::shared_ptr<IdentifierMapping const> idMap_) {
+    idMap = idMap_;
+    referenceGenomeID = seedFile.referenceGenomeID();
+    resetExtension();
+
+    auto seed = seedFile.seed(seedIndex);
+    occurrenceSetType occurrences;
+    for (size_t i = 0; i < seed.nOccurrences; ++i) {
+        occurrences.insert(seedFile.annoKey(seed.occurrences[i]));
+    }
+
+    std::unordered_set<MetagraphInterface::NodeID> nonDupNodeIDs;
+    nonDupNodeIDs.insert(seed.nodeIDs, seed.nodeIDs + seed.nNodeIDs);
+
+    initFirstTip(nonDupNodeIDs, occurrences, seed.nOccurrences);
+}
+void SeedExtension::initFirstTip(std::unordered_set<MetagraphInterface::NodeID> const & nodeIDs,
+                                 occurrenceSetType const & occurrences,
+                                 size_t nOccurrences) {
+    auto firstAllTips = std::make_shared<AllTips>(AllTips{});
+
+    for (auto nodeID : nodeIDs) {
+        if (graph.isSkipped(nodeID)) {
+            continue;
+        }
         auto firstTip = std::make_shared<PathBundleTip>(PathBundleTip{});
         firstTip->nodeID = nodeID;
 
         //only consider annos in graph which were provided by link = seed
-        for (auto & occurrence : link->occurrence()) {
-            for (auto & metaAnno : graph->getAnnotation(nodeID)) {
-                if (idMap->queryGenomeName(occurrence.genome()) == metaAnno.genome &&
-                    idMap->querySequenceName(occurrence.sequence()) == metaAnno.sequence &&
-                    occurrence.reverse() == metaAnno.reverse_strand &&
-                    occurrence.position() == metaAnno.bin_idx) {
-
-                    firstTip->annotations.insert({metaAnno,{0,0,0,0}});
-                }
+        for (auto & metaAnno : graph.getColors(nodeID).annotations) {
+            if (occurrences.find(metaAnno) != occurrences.end()) {
+                firstTip->annotations.insert({metaAnno,{0,0,0,0}});
             }
         }
         firstAllTips->tips.insert({nodeID, firstTip});
     }
 
+    initHistories(firstAllTips, nOccurrences);
+}
+void SeedExtension::resetExtension() {
+    tipsHistory.clear();
+    upStreamTipsHistory.clear();
+    downStreamHistoryLength = 0;
+    upStreamHistoryLength = 0;
+    // no references into graph are held anymore
+    if (ownsGraph) {
+        graph.trim();
+    }
+
+    // for extension analysis
+    tooManyDeletedAnnos = 0;
+    nMerges = 0;
+    nSplits = 0;
+    tooManyAnnosInInit = 0;
+    maxUpstreamSteps = 0;
+    maxSteps = 0;
+    nFastForwardedSteps = 0;
+    nLinearSteps = 0;
+    touchedNodes.clear();
+    nCycles = 0;
+    downStreamStates = VisitedStates();
+    upStreamStates = VisitedStates();
+
+    memoryCapReached = false;
+    memoryInUse = 0;
+    peakMemoryUsage = 0;
+
+    truncated = false;
+    nStepsMade = 0;
+    timeUsed = 0;
+}
+void SeedExtension::initHistories(std::shared_ptr<AllTips> firstAllTips, size_t nOccurrences) {
     firstAllTips->numberOfExtensionsMade = 0;
     firstAllTips->totalScore = 0;
 
-    tooManyAnnosInInit = firstAllTips->nAnnotations() - link->occurrence().size();
+    tooManyAnnosInInit = firstAllTips->nAnnotations() - nOccurrences;
 
-    tipsHistory.push_back(firstAllTips);
-    upStreamTipsHistory.push_back(std::make_shared<AllTips>(*firstAllTips));
+    pushStep(tipsHistory, firstAllTips);
+    pushStep(upStreamTipsHistory, std::make_shared<AllTips>(*firstAllTips));
+    if (cyclePolicy != ignoreCycles) {
+        std::vector<ColorClasses::AnnoKey> cyclingAnnos;
+        visitStates(false, *firstAllTips, cyclingAnnos);
+        visitStates(true, *firstAllTips, cyclingAnnos);
+    }
     // score of initial kmners assigned to downStream annos
     // dont initScore for upStream, bc then score of initial kmer would count twice to totalScore
     tipsHistory.back()->initScore(graph);
@@ -71,37 +142,355 @@ void SeedExtension::extend(size_t sufficientMaxScore) {
 void SeedExtension::extendOneSide(size_t sufficientMaxScore,
                                   std::vector<std::shared_ptr<AllTips>> & tipsHis,
                                   bool upStream) {
-    while (tipsHis.back()->nGenomes() >= 2 &&
-           totalScore()  < (int)sufficientMaxScore &&
-           tipsHis.back()->containsReferenzGenome(idMap) &&
-           tipsHis.size() < sufficientMaxScore * 3) { //catches potential inf loop
+    while (extendOneStep(sufficientMaxScore, tipsHis, upStream)) {}
+}
 
-        std::vector<int> splitsAndMerge{0,0}; // collects some info about extension
-        auto newStep = tipsHis.back()->extendAllTipsWithAnalysis(graph, upStream, binsize, splitsAndMerge);
-        nSplits += splitsAndMerge[0];
-        nMerges += splitsAndMerge[1];
+bool SeedExtension::extendOneStep(size_t sufficientMaxScore,
+                                  std::vector<std::shared_ptr<AllTips>> & tipsHis,
+                                  bool upStream) {
+    if (!canExtend(sufficientMaxScore, tipsHis)) {
+        return false;
+    }
+
+    auto stepStart = std::chrono::steady_clock::now();
+    auto nFastForwardedStepsBefore = nFastForwardedSteps;
+    if (fastForward && fastForwardUnitig(sufficientMaxScore, tipsHis, upStream)) {
+        nStepsMade += 1 + nFastForwardedSteps - nFastForwardedStepsBefore;
+        checkBudget(stepStart, tipsHis);
+        return true;
+    }
+
+    extendWithoutXDrop(tipsHis, upStream);
 
-        tipsHis.push_back(newStep); // add new AllTips to back of Alignment
-        if (upStream) {
-            maxUpstreamSteps = newStep->numberOfExtensionsMade;
+    if (cyclePolicy != ignoreCycles) {
+        std::vector<ColorClasses::AnnoKey> cyclingAnnos;
+        visitStates(upStream, *tipsHis.back(), cyclingAnnos);
+        // the step is undone, so there is nothing to xDrop
+        if (cyclingAnnos.size() != 0) {
+            cutCycles(tipsHis, upStream, cyclingAnnos);
+            finishStep(stepStart, tipsHis);
+            return true;
         }
-        else {
-            maxSteps = newStep->numberOfExtensionsMade;
+    }
+
+    // delete some annos if necessary
+    xDrop(xdrop, tipsHis, upStream);
+
+    finishStep(stepStart, tipsHis);
+    return true;
+}
+bool SeedExtension::canExtend(size_t sufficientMaxScore,
+                              std::vector<std::shared_ptr<AllTips>> const & tipsHis) const {
+    return(!memoryCapReached && !truncated &&
+           !visitedStates(&tipsHis == &upStreamTipsHistory).isStopped &&
+           tipsHis.back()->nGenomes() >= 2 &&
+           totalScore()  < (int)sufficientMaxScore &&
+           tipsHis.back()->containsInternedGenome(referenceGenomeID) &&
+           historyLength(tipsHis) < sufficientMaxScore * 3); //catches potential inf loop
+}
+void SeedExtension::extendWithoutXDrop(std::vector<std::shared_ptr<AllTips>> & tipsHis,
+                                       bool upStream) {
+    std::vector<int> splitsAndMerge{0,0}; // collects some info about extension
+    auto newStep = tipsHis.back()->extendAllTipsWithAnalysis(graph, upStream, binsize, splitsAndMerge);
+    nSplits += splitsAndMerge[0];
+    nMerges += splitsAndMerge[1];
+
+    pushStep(tipsHis, newStep); // add new AllTips to back of Alignment
+    if (upStream) {
+        maxUpstreamSteps = newStep->numberOfExtensionsMade;
+    }
+    else {
+        maxSteps = newStep->numberOfExtensionsMade;
+    }
+}
+void SeedExtension::finishStep(std::chrono::steady_clock::time_point stepStart,
+                               std::vector<std::shared_ptr<AllTips>> & tipsHis) {
+    // stop this seed, the alignment found so far is kept
+    if (memoryCap != 0 && memoryInUse > memoryCap) {
+        memoryCapReached = true;
+    }
+    nStepsMade++;
+    checkBudget(stepStart, tipsHis);
+}
+void SeedExtension::checkBudget(std::chrono::steady_clock::time_point stepStart,
+                                std::vector<std::shared_ptr<AllTips>> & tipsHis) {
+    timeUsed += std::chrono::duration<double>(std::chrono::steady_clock::now() - stepStart).count();
+    bool budgetReached = (stepBudget != 0 && nStepsMade >= stepBudget) ||
+                         (timeBudget != 0 && timeUsed >= timeBudget);
+    if (budgetReached) {
+        truncated = true;
+        undoToMaxScore(tipsHis);
+    }
+}
+// the other direction is either finished or not started yet, so it is left as it is
+void SeedExtension::undoToMaxScore(std::vector<std::shared_ptr<AllTips>> & tipsHis) {
+    size_t best = 0;
+    for (size_t i = 1; i < tipsHis.size(); i++) {
+        if (tipsHis[i]->totalScore > tipsHis[best]->totalScore) {
+            best = i;
         }
+    }
+    while (tipsHis.size() > best + 1) {
+        popStep(tipsHis);
+    }
+    forgetUndoneStates(tipsHis);
+}
+void SeedExtension::visitStates(bool upStream,
+                                AllTips const & allTips,
+                                std::vector<ColorClasses::AnnoKey> & cyclingAnnos) {
+    auto & visited = visitedStates(upStream);
+    for (auto const & [nodeID, tip] : allTips.tips) {
+        for (auto const & anno : tip->annotations) {
+            State state{nodeID, anno.first};
+            if (visited.states.insert(state).second) {
+                visited.log.push_back({allTips.numberOfExtensionsMade, state});
+            }
+            else {
+                cyclingAnnos.push_back(anno.first);
+            }
+        }
+    }
+}
+bool SeedExtension::closesCycle(bool upStream,
+                                PathBundleTip const & tip,
+                                MetagraphInterface::NodeID outID,
+                                std::vector<std::pair<ColorClasses::AnnoKey, ColorClasses::AnnoKey>> const & transitions) const {
+    auto const & visited = visitedStates(upStream);
+    for (auto const & anno : tip.annotations) {
+        auto nextAnno = anno.first;
+        for (auto const & [from, to] : transitions) {
+            if (from == anno.first) {
+                nextAnno = to;
+            }
+        }
+        if (visited.states.count(State{outID, nextAnno}) != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+// the step before the last one was made by extendWithoutXDrop() or fastForwardUnitig(),
+// so the history has an entry for it
+void SeedExtension::cutCycles(std::vector<std::shared_ptr<AllTips>> & tipsHis,
+                              bool upStream,
+                              std::vector<ColorClasses::AnnoKey> & cyclingAnnos) {
+    nCycles += cyclingAnnos.size();
+    auto stepBefore = tipsHis.back()->numberOfExtensionsMade - 1;
+    if (cyclePolicy == dropCyclingAnnos) {
+        auto nAnnotationsBefore = tipsHis[tipsHis.size() - 2]->nAnnotations();
+        applyXDrop(tipsHis, upStream, stepBefore, cyclingAnnos);
+        if (tipsHis.back()->nAnnotations() < nAnnotationsBefore) {
+            return;
+        }
+        // the annos were not found in the step before, the next step would close the cycle again
+    }
+    undoSteps(tipsHis, stepBefore);
+    visitedStates(upStream).isStopped = true;
+}
+void SeedExtension::forgetUndoneStates(std::vector<std::shared_ptr<AllTips>> const & tipsHis) {
+    auto & visited = visitedStates(&tipsHis == &upStreamTipsHistory);
+    auto step = tipsHis.back()->numberOfExtensionsMade;
+    while (!visited.log.empty() && visited.log.back().first > step) {
+        visited.states.erase(visited.log.back().second);
+        visited.log.pop_back();
+    }
+}
+bool SeedExtension::fastForwardUnitig(size_t sufficientMaxScore,
+                                      std::vector<std::shared_ptr<AllTips>> & tipsHis,
+                                      bool upStream) {
+    if (tipsHis.back()->tips.size() != 1) {
+        return false;
+    }
+    double otherSideTotalScore = upStream ?
+                                 tipsHistory.back()->totalScore :
+                                 upStreamTipsHistory.back()->totalScore;
+    size_t nHistoryEntries = historyLength(tipsHis);
+    // the time of this call is added to timeUsed by checkBudget() afterwards
+    auto start = std::chrono::steady_clock::now();
+    std::shared_ptr<AllTips> fastForwarded; // copy of tipsHis.back(), made when the first step is possible
+    uint64_t nSteps = 0;
+    LinearRun linearRun;
+    while (true) {
+        auto const & allTips = fastForwarded ? fastForwarded : tipsHis.back();
+        // the annos dont change, so only these conditions of extendOneStep() can change
+        if (nSteps > 0 &&
+            ((int)(otherSideTotalScore + allTips->totalScore) >= (int)sufficientMaxScore ||
+             nHistoryEntries + nSteps >= sufficientMaxScore * 3 ||
+             (stepBudget != 0 && nStepsMade + nSteps >= stepBudget) ||
+             (timeBudget != 0 &&
+              timeUsed + std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() >= timeBudget))) {
+            break;
+        }
+        auto const & tip = allTips->tips.begin()->second;
+        MetagraphInterface::NodeID outID;
+        std::vector<std::pair<ColorClasses::AnnoKey, ColorClasses::AnnoKey>> transitions;
+        bool isLinearStep = linearGenomes &&
+                            linearStep(*tip, upStream, allTips->numberOfExtensionsMade,
+                                       sufficientMaxScore * 3, linearRun, outID, transitions);
+        if (!isLinearStep &&
+            !tip->continuesUnchanged(graph, upStream, binsize, allTips->numberOfExtensionsMade, outID)) {
+            break;
+        }
+        // the step that closes a cycle is made by extendOneStep(), which applies cyclePolicy
+        if (cyclePolicy != ignoreCycles && closesCycle(upStream, *tip, outID, transitions)) {
+            break;
+        }
+        if (!fastForwarded) {
+            fastForwarded = std::make_shared<AllTips>(*tipsHis.back());
+        }
+        // same as extendAllTips(), but in place
+        auto bundle = fastForwarded->tips.begin()->second;
+        fastForwarded->tips.clear();
+        bundle->nodeID = outID;
+        for (auto const & [from, to] : transitions) {
+            auto anno = bundle->annotations.extract(from);
+            anno.key() = to;
+            anno.mapped().latestTransition = fastForwarded->numberOfExtensionsMade + 1;
+            bundle->annotations.insert(std::move(anno));
+        }
+        nLinearSteps += isLinearStep ? 1 : 0;
+        // only the last node of the unitig gets into the history
+        if (recordTouchedNodes) {
+            touchedNodes.insert(outID);
+        }
+        fastForwarded->tips.insert({outID, bundle});
+        fastForwarded->numberOfExtensionsMade++;
+        fastForwarded->updateScores(upStream, graph, fastForwarded->totalScore);
+        nSteps++;
+        if (cyclePolicy != ignoreCycles) {
+            std::vector<ColorClasses::AnnoKey> cyclingAnnos;
+            visitStates(upStream, *fastForwarded, cyclingAnnos);
+        }
+
+        // the step in which xDrop triggers needs its own history entry
+        std::vector<ColorClasses::AnnoKey> annosToBeDropped;
+        getAnnosToBeDropped(xdrop, fastForwarded, annosToBeDropped);
+        if (annosToBeDropped.size() != 0) {
+            break;
+        }
+    }
+    if (nSteps == 0) {
+        return false;
+    }
+    fastForwarded->nFastForwardedSteps = nSteps - 1;
+    nFastForwardedSteps += nSteps - 1;
+    pushStep(tipsHis, fastForwarded);
+    if (upStream) {
+        maxUpstreamSteps = fastForwarded->numberOfExtensionsMade;
+    }
+    else {
+        maxSteps = fastForwarded->numberOfExtensionsMade;
+    }
 
-        // delete some annos if necessary
-        xDrop(config->xdrop(), tipsHis, upStream);
+    xDrop(xdrop, tipsHis, upStream);
+
+    if (memoryCap != 0 && memoryInUse > memoryCap) {
+        memoryCapReached = true;
     }
+    return true;
+}
+bool SeedExtension::linearStep(PathBundleTip const & tip,
+                               bool upStream,
+                               uint64_t numberOfExtensionsMade,
+                               size_t maxSteps,
+                               LinearRun & run,
+                               MetagraphInterface::NodeID & outID,
+                               std::vector<std::pair<ColorClasses::AnnoKey, ColorClasses::AnnoKey>> & transitions) {
+    if (!run.isStarted) {
+        run.isStarted = true;
+        run.nSteps = maxSteps;
+        auto const & kmer = graph.getKmer(tip.nodeID);
+        // a track with two annos isnt a linear path
+        std::unordered_set<ColorClasses::TrackID> tracks;
+        for (auto const & annoScore : tip.annotations) {
+            LinearGenomes::Locus locus;
+            if (!tracks.insert(annoScore.first.track).second ||
+                !linearGenomes->locate(annoScore.first, kmer, locus)) {
+                run.nSteps = 0;
+                return false;
+            }
+            run.annos.push_back(annoScore.first);
+            run.loci.push_back(locus);
+            // stops early if the annos diverge right away
+            run.nSteps = linearGenomes->syncedSteps({run.loci.front(), locus}, upStream, run.nSteps);
+            if (run.nSteps == 0) {
+                return false;
+            }
+        }
+    }
+    if (run.nSteps == 0) {
+        return false;
+    }
+    char nextBase = linearGenomes->nextBase(run.loci.front(), upStream);
+    auto const & neighbours = upStream ? graph.getIncoming(tip.nodeID) : graph.getOutgoing(tip.nodeID);
+    auto next = std::find_if(neighbours.begin(), neighbours.end(), [&](MetagraphInterface::NodeID neighbour) {
+        return (upStream ? graph.getKmer(neighbour).front() : graph.getKmer(neighbour).back()) == nextBase;
+    });
+    if (next == neighbours.end()) {
+        run.nSteps = 0;
+        return false;
+    }
+    auto annos = run.annos;
+    auto loci = run.loci;
+    for (size_t i = 0; i < loci.size(); i++) {
+        loci[i].position = upStream ? loci[i].position - 1 : loci[i].position + 1;
+        uint64_t bin = loci[i].position / binsize * binsize;
+        if (bin == annos[i].bin_idx) {
+            continue;
+        }
+        // the same check as in PathBundleTip::extendTip(), the graph would drop this anno
+        uint64_t latestTransition = tip.annotations.at(annos[i]).latestTransition;
+        if (latestTransition != 0 && numberOfExtensionsMade + 1 - latestTransition < binsize) {
+            run.nSteps = 0;
+            return false;
+        }
+        transitions.push_back({annos[i], ColorClasses::AnnoKey{annos[i].track, bin}});
+        annos[i].bin_idx = bin;
+    }
+    outID = *next;
+    run.annos = annos;
+    run.loci = loci;
+    run.nSteps--;
+    return true;
+}
+// history entries that were skipped by fastForwardUnitig() count, so that
+// the guard against infinite loops in canExtend() stops at the same step
+void SeedExtension::pushStep(std::vector<std::shared_ptr<AllTips>> & tipsHis,
+                             std::shared_ptr<AllTips> allTips) {
+    memoryInUse += allTips->memoryUsage();
+    peakMemoryUsage = std::max(peakMemoryUsage, memoryInUse);
+    auto & length = &tipsHis == &upStreamTipsHistory ? upStreamHistoryLength : downStreamHistoryLength;
+    length += 1 + allTips->nFastForwardedSteps;
+    tipsHis.push_back(allTips);
+    if (recordTouchedNodes) {
+        for (auto const & tip : allTips->tips) {
+            touchedNodes.insert(tip.first);
+        }
+    }
+}
+void SeedExtension::popStep(std::vector<std::shared_ptr<AllTips>> & tipsHis) {
+    memoryInUse -= tipsHis.back()->memoryUsage();
+    auto & length = &tipsHis == &upStreamTipsHistory ? upStreamHistoryLength : downStreamHistoryLength;
+    length -= 1 + tipsHis.back()->nFastForwardedSteps;
+    tipsHis.pop_back();
 }
 //! find the annos in current allTips which have a score less than:
 //! their their maxscore - xdrop
 //! and are furthest in the past
 size_t SeedExtension::getAnnosToBeDropped(uint64_t xdrop,
                                      std::shared_ptr<AllTips> allTips,
-                                     std::vector<MetagraphInterface::NodeAnnotation> & annosToBeDropped) const {
+                                     std::vector<ColorClasses::AnnoKey> & annosToBeDropped) const {
+    if (AllTips::isParallel(allTips->tips.size())) {
+        return getAnnosToBeDroppedInParallel(xdrop, allTips, annosToBeDropped);
+    }
     auto xDropFurthestBack = allTips->numberOfExtensionsMade;
     for (auto & [nodeID, tip] : allTips->tips) {
-        for (auto & [metaAnno, annoScore] : tip->annotations) {
+        // most bundles can be skipped without looking at their annos
+        if (tip->cannotBeDropped(xdrop)) {
+            continue;
+        }
+        for (auto & [metaAnno, scoreWithoutOffset] : tip->annotations) {
+            auto annoScore = tip->effectiveScore(scoreWithoutOffset);
             if (annoScore.currentScore < annoScore.maxScore - xdrop ) {
                 // delete only the xdrop with the maxscore furthest in the past
                 if (annosToBeDropped.size() == 0 ||
@@ -122,6 +511,52 @@ size_t SeedExtension::getAnnosToBeDropped(uint64_t xdrop,
     }
     return(xDropFurthestBack);
 }
+// the result of the serial loop are all annos with the oldest ageOfMaxScore in the order of tips,
+// so every chunk looks for its oldest annos and the chunks with the overall oldest are concatenated
+size_t SeedExtension::getAnnosToBeDroppedInParallel(uint64_t xdrop,
+                                                   std::shared_ptr<AllTips> allTips,
+                                                   std::vector<ColorClasses::AnnoKey> & annosToBeDropped) const {
+    auto bundles = allTips->frontier();
+    std::vector<std::vector<ColorClasses::AnnoKey>> chunkAnnos(AllTips::nThreads);
+    std::vector<uint64_t> chunkFurthestBack(AllTips::nThreads, allTips->numberOfExtensionsMade);
+    AllTips::forEachChunk(bundles.size(), AllTips::nThreads, [&](size_t chunk, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            auto const & tip = *bundles[i].second;
+            if (tip.cannotBeDropped(xdrop)) {
+                continue;
+            }
+            for (auto & [metaAnno, scoreWithoutOffset] : tip.annotations) {
+                auto annoScore = tip.effectiveScore(scoreWithoutOffset);
+                if (annoScore.currentScore < annoScore.maxScore - xdrop) {
+                    if (chunkAnnos[chunk].size() == 0 ||
+                        annoScore.ageOfMaxScore == chunkFurthestBack[chunk]) {
+                        chunkAnnos[chunk].push_back(metaAnno);
+                        chunkFurthestBack[chunk] = annoScore.ageOfMaxScore;
+                    }
+                    else if (annoScore.ageOfMaxScore < chunkFurthestBack[chunk]) {
+                        chunkAnnos[chunk].clear();
+                        chunkAnnos[chunk].push_back(metaAnno);
+                        chunkFurthestBack[chunk] = annoScore.ageOfMaxScore;
+                    }
+                }
+            }
+        }
+    });
+    auto xDropFurthestBack = allTips->numberOfExtensionsMade;
+    bool found = false;
+    for (size_t chunk = 0; chunk < chunkAnnos.size(); chunk++) {
+        if (chunkAnnos[chunk].size() != 0 && (!found || chunkFurthestBack[chunk] < xDropFurthestBack)) {
+            xDropFurthestBack = chunkFurthestBack[chunk];
+            found = true;
+        }
+    }
+    for (size_t chunk = 0; chunk < chunkAnnos.size(); chunk++) {
+        if (chunkAnnos[chunk].size() != 0 && chunkFurthestBack[chunk] == xDropFurthestBack) {
+            annosToBeDropped.insert(annosToBeDropped.end(), chunkAnnos[chunk].begin(), chunkAnnos[chunk].end());
+        }
+    }
+    return(xDropFurthestBack);
+}
 // cant just do multi pop here, since when xdrop triggers, a copy of allTips is made
 // and pushed to vector but with identical numberOfExtensionsMade
 // therefore vector index is not always equal to vector[index].numberOfExtensionsMade
@@ -131,13 +566,14 @@ void SeedExtension::undoSteps(std::vector<std::shared_ptr<AllTips>> & tipsHis,
                               size_t goBackTo) {
     uint64_t latestNumberOfExtensionsMade = tipsHis.back()->numberOfExtensionsMade;
     while (latestNumberOfExtensionsMade != goBackTo) {
-        tipsHis.pop_back();
+        popStep(tipsHis);
         latestNumberOfExtensionsMade = tipsHis.back()->numberOfExtensionsMade;
     }
+    forgetUndoneStates(tipsHis);
 }
 std::vector<unsigned>
 SeedExtension::removeAnnos(tipsMapType & tips,
-                           std::vector<MetagraphInterface::NodeAnnotation> & annosToBeDropped,
+                           std::vector<ColorClasses::AnnoKey> & annosToBeDropped,
                            bool upStream,
                            size_t nBackSteps) {
     // to update score after annos have been removed
@@ -147,8 +583,8 @@ SeedExtension::removeAnnos(tipsMapType & tips,
         for (auto tipItr = tips.begin(); tipItr != tips.end(); ) {
             auto & tip = tipItr->second;
             char base = upStream ?
-                        graph->getKmer(tip->nodeID).front() :
-                        graph->getKmer(tip->nodeID).back();
+                        graph.getKmer(tip->nodeID).front() :
+                        graph.getKmer(tip->nodeID).back();
             auto foundAnnoPtr = tip->annotations.find(annoToBeDropped);
             if (foundAnnoPtr != tip->annotations.end()) {
                 //add base to acgt to return, to update score after xdrop
@@ -173,10 +609,8 @@ SeedExtension::removeAnnos(tipsMapType & tips,
                         continue;
                     }
                     // modified annoToBeDropped used for searching anno with different bin_idx
-                    MetagraphInterface::NodeAnnotation upStreamAnno {annoToBeDropped.genome,
-                                                                     annoToBeDropped.sequence,
-                                                                     annoToBeDropped.reverse_strand,
-                                                                     annoToBeDropped.bin_idx - tilediff};
+                    ColorClasses::AnnoKey upStreamAnno {annoToBeDropped.track,
+                                                        annoToBeDropped.bin_idx - tilediff};
                     auto foundUpStreamAnnoPtr = tip->annotations.find(upStreamAnno);
                     if (foundUpStreamAnnoPtr != tip->annotations.end()) {
                         acgt[AllTips::baseToId(base)] += 1;
@@ -199,13 +633,22 @@ SeedExtension::removeAnnos(tipsMapType & tips,
 void SeedExtension::xDrop(uint64_t xdrop,
                           std::vector<std::shared_ptr<AllTips>> & tipsHis,
                           bool upStream) {
-
-    std::vector<MetagraphInterface::NodeAnnotation> annosToBeDropped;
-    auto goBackTo = getAnnosToBeDropped(xdrop, tipsHis.back(), annosToBeDropped);
+    std::vector<ColorClasses::AnnoKey> annosToBeDropped;
+    auto goBackTo = decideXDrop(xdrop, tipsHis.back(), annosToBeDropped);
+    applyXDrop(tipsHis, upStream, goBackTo, annosToBeDropped);
+}
+size_t SeedExtension::decideXDrop(uint64_t xdrop,
+                                  std::shared_ptr<AllTips> allTips,
+                                  std::vector<ColorClasses::AnnoKey> & annosToBeDropped) const {
+    auto goBackTo = getAnnosToBeDropped(xdrop, allTips, annosToBeDropped);
     // if goBackTo is close to nodes where extension started
     // go back to start instead
-    goBackTo = goBackTo < 5 ? 0 : goBackTo;
-
+    return(goBackTo < 5 ? 0 : goBackTo);
+}
+void SeedExtension::applyXDrop(std::vector<std::shared_ptr<AllTips>> & tipsHis,
+                               bool upStream,
+                               size_t goBackTo,
+                               std::vector<ColorClasses::AnnoKey> & annosToBeDropped) {
     size_t nBackSteps = tipsHis.back()->numberOfExtensionsMade - goBackTo;
 
     if (annosToBeDropped.size() != 0) {
@@ -232,17 +675,16 @@ void SeedExtension::xDrop(uint64_t xdrop,
         //update score after annos were removed
         for (auto & [id, tip] : trimmedAllTips->tips) {
             char currentBase = upStream ?
-                               graph->getKmer(id).front() :
-                               graph->getKmer(id).back();
-            for (auto & [anno, scoreStructure] : tip->annotations) {
-                auto score = trimmedAllTips->charVsProfileScore(currentBase, nACGTBeforeRemove);
-                scoreStructure.currentScore -= score;
-                score = trimmedAllTips->charVsProfileScore(currentBase, nACGTAfterRemove);
-                scoreStructure.currentScore += score;
-            }
+                               graph.getKmer(id).front() :
+                               graph.getKmer(id).back();
+            // same for all annos of the bundle
+            auto score = trimmedAllTips->charVsProfileScore(currentBase, nACGTBeforeRemove);
+            tip->addToScores(-score);
+            score = trimmedAllTips->charVsProfileScore(currentBase, nACGTAfterRemove);
+            tip->addToScores(score);
         }
 
-        tipsHis.push_back(trimmedAllTips);
+        pushStep(tipsHis, trimmedAllTips);
 
         if (nAnnotationsBeforeXDrop != nACGTBeforeRemove[0] + nACGTBeforeRemove[1] + nACGTBeforeRemove[2] + nACGTBeforeRemove[3]) {
             std::cout << "something went wrong SeedExtension nAnnotationsBeforeXDrop" << '\n';
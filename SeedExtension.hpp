@@ -6,10 +6,18 @@
 #include "MetagraphInterface.h"
 #include "Link.h"
 #include "AllTips.hpp"
+#include "ColorClasses.hpp"
+#include "LinearGenomes.hpp"
+#include "NodeCache.hpp"
+#include "SeedFile.hpp"
 
 
+#include <chrono>
+#include <functional>
 #include <iostream>
 #include <memory>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 /* Holds a vector of AllTips for upStream and downStream
@@ -20,6 +28,31 @@ class SeedExtension{
 
 public:
     using tipsMapType = std::unordered_map<uint64_t, std::shared_ptr<PathBundleTip>>;
+    //! the occurrences of a seed in interned form
+    using occurrenceSetType = std::unordered_set<ColorClasses::AnnoKey, ColorClasses::HashAnnoKey>;
+    //! what happens when an annotation gets back to a node, see cyclePolicy
+    enum CyclePolicy {ignoreCycles, dropCyclingAnnos, stopAtCycles};
+    //! an annotation in a node, the extension is in a cycle if it reaches a state twice
+    struct State {
+        MetagraphInterface::NodeID nodeID;
+        ColorClasses::AnnoKey anno;
+        bool operator==(State const & other) const {
+            return nodeID == other.nodeID && anno == other.anno;
+        }
+    };
+    struct HashState {
+        std::size_t operator()(State const & state) const {
+            return ColorClasses::hashCombine(ColorClasses::HashAnnoKey()(state.anno), state.nodeID);
+        }
+    };
+    //! the states reached in one direction
+    struct VisitedStates {
+        std::unordered_set<State, HashState> states;
+        //! (extension step, state) in the order they were reached, to forget the states of undone steps
+        std::vector<std::pair<uint64_t, State>> log;
+        //! true if the direction was stopped at a cycle
+        bool isStopped = false;
+    };
 
     SeedExtension(size_t binsize_):tipsHistory{},
                     upStreamTipsHistory{},
@@ -28,7 +61,8 @@ public:
                     idMap{},
                     binsize{binsize_} {};
 
-    SeedExtension(std::shared_ptr<MetagraphInterface const> graph_,
+    //! graph_ can be shared, the caller trims it between two steps (see NodeCache::trim())
+    SeedExtension(NodeCache graph_,
                   std::shared_ptr<Configuration const> config_,
                   size_t binsize_):
                tipsHistory{},
@@ -36,21 +70,133 @@ public:
                graph{graph_},
                config{config_},
                idMap{},
-               binsize{binsize_}{}
+               binsize{binsize_},
+               xdrop{config_ ? config_->xdrop() : 0} {}
+
+    //! queries graph_ through a cache that only this extension uses
+    /*! the cache keeps only the nodes of the current seed, see ownsGraph */
+    SeedExtension(std::shared_ptr<MetagraphInterface const> graph_,
+                  std::shared_ptr<Configuration const> config_,
+                  size_t binsize_):
+               SeedExtension(NodeCache(graph_, 0), config_, binsize_) {
+        ownsGraph = true;
+    }
+
+    //! without Configuration, e.g. for a run from a trace (see replayBenchmark.cpp)
+    SeedExtension(NodeCache graph_,
+                  uint64_t xdrop_,
+                  size_t binsize_):
+               tipsHistory{},
+               upStreamTipsHistory{},
+               graph{graph_},
+               config{},
+               idMap{},
+               binsize{binsize_},
+               xdrop{xdrop_} {}
 
     //! calls the extention to both sides (upstream and downstream)
     void extend(size_t sufficientMaxScore);
     void extendOneSide(size_t sufficientMaxScore,
                        std::vector<std::shared_ptr<AllTips>> & tipsHis,
                        bool upStream);
+    //! makes one extension step (incl. xDrop) if the extension in this direction isnt finished
+    /*! returns false if no step was made, i.e. the extension in this direction is finished
+     * used by MultiSeedExtension to extend several seeds in lockstep
+     */
+    bool extendOneStep(size_t sufficientMaxScore,
+                       std::vector<std::shared_ptr<AllTips>> & tipsHis,
+                       bool upStream);
+    //! returns true if the extension in this direction isnt finished, see extendOneStep()
+    bool canExtend(size_t sufficientMaxScore,
+                   std::vector<std::shared_ptr<AllTips>> const & tipsHis) const;
+    //! the extension step of extendOneStep() without fast forward and xDrop
+    void extendWithoutXDrop(std::vector<std::shared_ptr<AllTips>> & tipsHis,
+                            bool upStream);
+    //! the checks of extendOneStep() after xDrop, i.e. memoryCap and budget
+    void finishStep(std::chrono::steady_clock::time_point stepStart,
+                    std::vector<std::shared_ptr<AllTips>> & tipsHis);
+    //! makes as many extension steps as possible through a non-branching path of the graph in place
+    /*! only if tipsHis.back() consists of one PathBundleTip and all its annos continue unchanged
+     * (see PathBundleTip::continuesUnchanged()) or, if linearGenomes is set, continue with the
+     * same base in their sequences (see linearStep()). The result is pushed as one history entry.
+     * It stops before the loop condition of extendOneSide() would fail and after
+     * a step in which xDrop triggers, so the result is equal to single steps.
+     * It also stops when stepBudget or timeBudget is reached, so a long unitig
+     * cannot run past the budget.
+     * returns false if no step was made
+     */
+    bool fastForwardUnitig(size_t sufficientMaxScore,
+                           std::vector<std::shared_ptr<AllTips>> & tipsHis,
+                           bool upStream);
+    //! the bundle of fastForwardUnitig() on linearGenomes
+    struct LinearRun {
+        bool isStarted = false;
+        std::vector<ColorClasses::AnnoKey> annos;
+        //! the start of the kmer of the bundle in the sequence of annos[i]
+        std::vector<LinearGenomes::Locus> loci;
+        //! number of steps left in which all annos continue with the same base
+        size_t nSteps = 0;
+    };
+    //! finds the next node of tip on linearGenomes, if the steps of run are not used up
+    /*! the run is started at the first call, with at most maxSteps steps.
+     * transitions are the annos that move to the next bin (old, new), like in PathBundleTip::extendTip()
+     * returns false if tip has to be extended through the graph
+     */
+    bool linearStep(PathBundleTip const & tip,
+                    bool upStream,
+                    uint64_t numberOfExtensionsMade,
+                    size_t maxSteps,
+                    LinearRun & run,
+                    MetagraphInterface::NodeID & outID,
+                    std::vector<std::pair<ColorClasses::AnnoKey, ColorClasses::AnnoKey>> & transitions);
+    //! returns the states of the direction upStream
+    VisitedStates & visitedStates(bool upStream) {
+        return upStream ? upStreamStates : downStreamStates;
+    }
+    VisitedStates const & visitedStates(bool upStream) const {
+        return upStream ? upStreamStates : downStreamStates;
+    }
+    //! adds the states of allTips, the annos whose state was reached before are added to cyclingAnnos instead
+    void visitStates(bool upStream,
+                     AllTips const & allTips,
+                     std::vector<ColorClasses::AnnoKey> & cyclingAnnos);
+    //! returns true if a step of tip to outID with transitions (see linearStep()) reaches a state again
+    bool closesCycle(bool upStream,
+                     PathBundleTip const & tip,
+                     MetagraphInterface::NodeID outID,
+                     std::vector<std::pair<ColorClasses::AnnoKey, ColorClasses::AnnoKey>> const & transitions) const;
+    //! applies cyclePolicy to the last step of tipsHis, in which cyclingAnnos got back to a node
+    void cutCycles(std::vector<std::shared_ptr<AllTips>> & tipsHis,
+                   bool upStream,
+                   std::vector<ColorClasses::AnnoKey> & cyclingAnnos);
+    //! forgets the states reached after the step of tipsHis.back()
+    void forgetUndoneStates(std::vector<std::shared_ptr<AllTips>> const & tipsHis);
+    //! number of extension steps in tipsHis, incl. the fast forwarded ones
+    size_t historyLength(std::vector<std::shared_ptr<AllTips>> const & tipsHis) const {
+        return &tipsHis == &upStreamTipsHistory ? upStreamHistoryLength : downStreamHistoryLength;
+    }
     //! for a given seed = link, init the first Alltips (T_0,e_0)
     void initFirstTip(std::vector<MetagraphInterface::NodeID> nodeIDs,
                       LinkPtr link,
                       std::shared_ptr<IdentifierMapping const> idMap);
+    //! same as above for the seed with index seedIndex of a SeedFile
+    /*! idMap may be nullptr, the reference genome is taken from the SeedFile */
+    void initFirstTip(SeedFile const & seedFile,
+                      size_t seedIndex,
+                      std::shared_ptr<IdentifierMapping const> idMap);
+    //! inits the first AllTips with the annos of nodeIDs that are in occurrences, see above
+    /*! nodes that are skipped by the repeat mask of graph (see NodeCache::isSkipped()) are left out */
+    void initFirstTip(std::unordered_set<MetagraphInterface::NodeID> const & nodeIDs,
+                      occurrenceSetType const & occurrences,
+                      size_t nOccurrences);
+    //! clears the histories and the statistics of the previous seed
+    void resetExtension();
+    //! pushes the first AllTips of a seed with nOccurrences occurrences to both histories
+    void initHistories(std::shared_ptr<AllTips> firstAllTips, size_t nOccurrences);
     //! removes the annos provided by annosToBeDropped from allTips
     std::vector<unsigned>
     removeAnnos(tipsMapType & allTips,
-                std::vector<MetagraphInterface::NodeAnnotation> & annosToBeDropped,
+                std::vector<ColorClasses::AnnoKey> & annosToBeDropped,
                 bool upStream,
                 size_t nBackSteps);
 
@@ -63,11 +209,39 @@ public:
     size_t
     getAnnosToBeDropped(uint64_t xdrop,
                         std::shared_ptr<AllTips> allTips,
-                        std::vector<MetagraphInterface::NodeAnnotation> & annosToBeDropped) const;
+                        std::vector<ColorClasses::AnnoKey> & annosToBeDropped) const;
+    //! same as getAnnosToBeDropped(), but with AllTips::nThreads threads
+    size_t
+    getAnnosToBeDroppedInParallel(uint64_t xdrop,
+                                  std::shared_ptr<AllTips> allTips,
+                                  std::vector<ColorClasses::AnnoKey> & annosToBeDropped) const;
     //! remove not-well matching annos and update score of last few extension steps
     void xDrop(uint64_t xdrop,
                std::vector<std::shared_ptr<AllTips>> & tipsHis,
                bool upStream);
+    //! the first half of xDrop(): determines the annos to be dropped and returns the step to go back to
+    size_t decideXDrop(uint64_t xdrop,
+                       std::shared_ptr<AllTips> allTips,
+                       std::vector<ColorClasses::AnnoKey> & annosToBeDropped) const;
+    //! the second half of xDrop(): goes back to goBackTo and removes annosToBeDropped, if there are any
+    void applyXDrop(std::vector<std::shared_ptr<AllTips>> & tipsHis,
+                    bool upStream,
+                    size_t goBackTo,
+                    std::vector<ColorClasses::AnnoKey> & annosToBeDropped);
+    //! appends allTips to tipsHis and accounts its memory and its steps (see historyLength())
+    void pushStep(std::vector<std::shared_ptr<AllTips>> & tipsHis,
+                  std::shared_ptr<AllTips> allTips);
+    //! removes the last AllTips of tipsHis, the reverse of pushStep()
+    void popStep(std::vector<std::shared_ptr<AllTips>> & tipsHis);
+    //! adds the time since stepStart to timeUsed and truncates tipsHis if the budget is reached
+    void checkBudget(std::chrono::steady_clock::time_point stepStart,
+                     std::vector<std::shared_ptr<AllTips>> & tipsHis);
+    //! undoes the steps after the AllTips with the highest totalScore in tipsHis
+    void undoToMaxScore(std::vector<std::shared_ptr<AllTips>> & tipsHis);
+    //! returns the number of bytes currently held by tipsHistory and upStreamTipsHistory
+    size_t memoryUsage() const {
+        return memoryInUse;
+    }
     //! returns the sum of scores of all annotations of all tips in current AllTips
     int totalScore() const{
         return(tipsHistory.back()->totalScore + upStreamTipsHistory.back()->totalScore);
@@ -77,10 +251,16 @@ public:
     //! all extensions steps made upstream
     std::vector<std::shared_ptr<AllTips>> upStreamTipsHistory;
 // private
-    std::shared_ptr<MetagraphInterface const> graph;
+    NodeCache graph;
+    //! graph is not shared with other extensions, so it is trimmed before every seed
+    bool ownsGraph = false;
     std::shared_ptr<Configuration const> config;
     std::shared_ptr<IdentifierMapping const> idMap;
     size_t binsize;
+    //! config->xdrop()
+    uint64_t xdrop;
+    //! interned genome 0 of idMap, set by initFirstTip()
+    uint32_t referenceGenomeID = 0;
 
     // for extension analysis
     int tooManyDeletedAnnos = 0;
@@ -89,6 +269,57 @@ public:
     int tooManyAnnosInInit = 0;
     int maxSteps = 0;
     int maxUpstreamSteps = 0;
+
+    //! extend through non-branching paths in one step, see fastForwardUnitig()
+    bool fastForward = false;
+    //! number of steps that were fast forwarded
+    int nFastForwardedSteps = 0;
+    //! sequences of the genomes to fast forward also through branching paths, nullptr if not wanted
+    std::shared_ptr<LinearGenomes const> linearGenomes;
+    //! number of steps that were fast forwarded on linearGenomes
+    int nLinearSteps = 0;
+
+    // cycle detection
+    //! ignoreCycles: cycles are only stopped by the limit on the history length in canExtend()
+    //! dropCyclingAnnos: the step is undone and the cycling annos are removed from the step before, like in xDrop
+    //! stopAtCycles: the step is undone and the extension in this direction is finished
+    CyclePolicy cyclePolicy = ignoreCycles;
+    //! number of annos that got back to a node they were in before
+    int nCycles = 0;
+    //! the states of both directions since initFirstTip, only kept if cyclePolicy isnt ignoreCycles
+    VisitedStates downStreamStates;
+    VisitedStates upStreamStates;
+
+    //! collect the nodes of every tip in touchedNodes, see TouchedNodes
+    bool recordTouchedNodes = false;
+    //! the nodes of all tips since initFirstTip, incl. steps that xDrop undid
+    std::unordered_set<MetagraphInterface::NodeID> touchedNodes;
+
+    // memory accounting
+    //! max number of bytes the histories of one seed may hold, 0 means unlimited
+    size_t memoryCap = 0;
+    //! true if the extension of the current seed was stopped, bc memoryCap was reached
+    bool memoryCapReached = false;
+    //! number of bytes currently held by the histories
+    size_t memoryInUse = 0;
+    //! historyLength() of tipsHistory and upStreamTipsHistory, kept by pushStep() and popStep()
+    size_t downStreamHistoryLength = 0;
+    size_t upStreamHistoryLength = 0;
+    //! max of memoryInUse since initFirstTip
+    size_t peakMemoryUsage = 0;
+
+    // budget per seed, when it is reached the extension in the current direction
+    // is cut back to its highest totalScore and the seed is stopped
+    //! max number of extension steps in both directions, 0 means unlimited
+    uint64_t stepBudget = 0;
+    //! max number of seconds spent in extendOneStep(), 0 means unlimited
+    double timeBudget = 0;
+    //! true if the budget was reached and the extension was cut back
+    bool truncated = false;
+    //! number of extension steps made since initFirstTip, incl. the fast forwarded ones
+    uint64_t nStepsMade = 0;
+    //! number of seconds spent in extendOneStep() since initFirstTip
+    double timeUsed = 0;
 };
 
 #endif //_SeedExtension_HPP_
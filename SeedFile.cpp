@@ -0,0 +1,195 @@
+#include "SeedFile.hpp"
+
+#include "ColorClasses.hpp"
+#include "MetagraphInterface.h"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// the node IDs are used in place
+static_assert(sizeof(MetagraphInterface::NodeID) == sizeof(uint64_t),
+              "SeedFile stores node IDs as uint64_t");
+
+constexpr char SeedFile::magic[8];
+
+void SeedFile::Writer::add(std::vector<MetagraphInterface::NodeID> const & seedNodeIDs,
+                           LinkPtr link,
+                           std::shared_ptr<IdentifierMapping const> idMap) {
+    referenceGenomeName = nameIndex(idMap->queryGenomeName(0));
+    nodeIDs.insert(nodeIDs.end(), seedNodeIDs.begin(), seedNodeIDs.end());
+    nodeIDOffsets.push_back(nodeIDs.size());
+    for (auto & occurrence : link->occurrence()) {
+        uint32_t genomeName = nameIndex(idMap->queryGenomeName(occurrence.genome()));
+        uint32_t sequenceName = nameIndex(idMap->querySequenceName(occurrence.sequence()));
+        bool reverse = occurrence.reverse();
+        auto track = trackIndices.insert({std::make_tuple(genomeName, sequenceName, reverse),
+                                          (uint32_t)tracks.size()});
+        if (track.second) {
+            tracks.push_back(Track{genomeName, sequenceName, reverse, 0});
+        }
+        occurrences.push_back(Occurrence{track.first->second, 0, (uint64_t)occurrence.position()});
+    }
+    occurrenceOffsets.push_back(occurrences.size());
+}
+
+uint32_t SeedFile::Writer::nameIndex(std::string const & name) {
+    auto found = nameIndices.insert({name, (uint32_t)names.size()});
+    if (found.second) {
+        names.push_back(name);
+    }
+    return found.first->second;
+}
+
+bool SeedFile::Writer::write(std::string const & path) const {
+    std::ofstream outf(path, std::ios::binary);
+    if (!outf) {
+        return false;
+    }
+    Header header{};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.nSeeds = nSeeds();
+    header.nNodeIDs = nodeIDs.size();
+    header.nOccurrences = occurrences.size();
+    header.nTracks = tracks.size();
+    header.nNames = names.size();
+    header.referenceGenomeName = referenceGenomeName < 0 ? names.size() : referenceGenomeName;
+
+    std::vector<uint64_t> nameOffsets{0};
+    for (auto const & name : names) {
+        nameOffsets.push_back(nameOffsets.back() + name.size());
+    }
+    auto writeVector = [&outf](auto const & vec) {
+        outf.write(reinterpret_cast<char const *>(vec.data()),
+                   vec.size() * sizeof(typename std::decay_t<decltype(vec)>::value_type));
+    };
+    outf.write(reinterpret_cast<char const *>(&header), sizeof(header));
+    writeVector(nodeIDOffsets);
+    writeVector(occurrenceOffsets);
+    writeVector(nodeIDs);
+    writeVector(occurrences);
+    writeVector(tracks);
+    writeVector(nameOffsets);
+    for (auto const & name : names) {
+        outf.write(name.data(), name.size());
+    }
+    return(bool(outf));
+}
+
+SeedFile::SeedFile(std::string const & path_):path{path_},
+                                               data{nullptr},
+                                               fileSize{0} {
+    // the destructor does not run if the constructor throws
+    auto fail = [this](std::string const & message) {
+        if (data != nullptr && data != MAP_FAILED) {
+            munmap(data, fileSize);
+        }
+        data = nullptr;
+        throw std::runtime_error("seed file " + path + ": " + message);
+    };
+    int fd = open(path.c_str(), O_RDONLY);
+    struct stat fileStat;
+    if (fd < 0 || fstat(fd, &fileStat) != 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        fail("cannot open");
+    }
+    fileSize = fileStat.st_size;
+    if (fileSize < sizeof(Header)) {
+        close(fd);
+        fail("too short");
+    }
+    data = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping stays valid
+    if (data == MAP_FAILED) {
+        fail("cannot map");
+    }
+    // seeds are read one after another
+    madvise(data, fileSize, MADV_SEQUENTIAL);
+
+    char const * bytes = static_cast<char const *>(data);
+    header = reinterpret_cast<Header const *>(bytes);
+    if (std::memcmp(header->magic, magic, sizeof(magic)) != 0) {
+        fail("not a seed file");
+    }
+    size_t offset = sizeof(Header);
+    // points begin to the next section of n elements
+    auto section = [&](auto const * & begin, uint64_t n) {
+        begin = reinterpret_cast<std::decay_t<decltype(*begin)> const *>(bytes + offset);
+        if (n > (fileSize - offset) / sizeof(*begin)) {
+            fail("truncated");
+        }
+        offset += n * sizeof(*begin);
+    };
+    // every range [offsets[i], offsets[i+1]) lies in [0, total)
+    auto isValid = [](uint64_t const * offsets, uint64_t n, uint64_t total) {
+        for (uint64_t i = 0; i < n; i++) {
+            if (offsets[i] > offsets[i + 1]) {
+                return false;
+            }
+        }
+        return offsets[0] == 0 && offsets[n] == total;
+    };
+    if (header->nSeeds == UINT64_MAX || header->nNames == UINT64_MAX) {
+        fail("corrupt header");
+    }
+    section(nodeIDOffsets, header->nSeeds + 1);
+    section(occurrenceOffsets, header->nSeeds + 1);
+    section(nodeIDs, header->nNodeIDs);
+    section(occurrences, header->nOccurrences);
+    section(tracks, header->nTracks);
+    section(nameOffsets, header->nNames + 1);
+    names = bytes + offset;
+    if (!isValid(nodeIDOffsets, header->nSeeds, header->nNodeIDs)) {
+        fail("node IDs of the seeds out of range");
+    }
+    if (!isValid(occurrenceOffsets, header->nSeeds, header->nOccurrences)) {
+        fail("occurrences of the seeds out of range");
+    }
+    if (!isValid(nameOffsets, header->nNames, nameOffsets[header->nNames])
+        || nameOffsets[header->nNames] > fileSize - offset) {
+        fail("names out of range");
+    }
+    for (uint64_t i = 0; i < header->nOccurrences; i++) {
+        if (occurrences[i].track >= header->nTracks) {
+            fail("occurrence " + std::to_string(i) + " has no track");
+        }
+    }
+
+    // the tracks are interned once per file, not once per occurrence
+    for (uint64_t i = 0; i < header->nTracks; i++) {
+        if (tracks[i].genomeName >= header->nNames || tracks[i].sequenceName >= header->nNames) {
+            fail("track " + std::to_string(i) + " has no name");
+        }
+        MetagraphInterface::NodeAnnotation anno;
+        anno.genome = name(tracks[i].genomeName);
+        anno.sequence = name(tracks[i].sequenceName);
+        anno.reverse_strand = tracks[i].reverse_strand;
+        anno.bin_idx = 0;
+        trackIDs.push_back(ColorClasses::trackID(anno));
+    }
+    referenceGenome = ColorClasses::genomeID(header->referenceGenomeName < header->nNames ?
+                                             name(header->referenceGenomeName) :
+                                             "");
+}
+
+SeedFile::~SeedFile() {
+    if (data != nullptr) {
+        munmap(data, fileSize);
+    }
+}
+
+std::string SeedFile::name(uint64_t nameIndex) const {
+    return std::string(names + nameOffsets[nameIndex],
+                       nameOffsets[nameIndex + 1] - nameOffsets[nameIndex]);
+}
@@ -0,0 +1,147 @@
+#ifndef _SeedFile_HPP_
+#define _SeedFile_HPP_
+
+#include "ColorClasses.hpp"
+#include "IdentifierMapping.h"
+#include "Link.h"
+#include "MetagraphInterface.h"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+/* Binary file of seeds that is memory mapped and read without copying
+* \details A seed consists of its node IDs and its occurrences, where an
+* occurrence refers to a track (genome, sequence, strand) by index into the
+* track table of the file. Names are stored once per file, so no IdentifierMapping
+* lookups are needed to initialize a seed (see SeedExtension::initFirstTip()).
+* The file also names the reference genome, so a seed can be extended without
+* IdentifierMapping (see replayBenchmark.cpp).
+* Files are written by SeedFile::Writer, e.g. from the links of GH.
+*
+* Layout (native byte order, every section 8 byte aligned):
+*   Header
+*   uint64_t   nodeIDOffsets[nSeeds + 1]      nodeIDs of seed i: [nodeIDOffsets[i], nodeIDOffsets[i+1])
+*   uint64_t   occurrenceOffsets[nSeeds + 1]  same for occurrences
+*   uint64_t   nodeIDs[nNodeIDs]
+*   Occurrence occurrences[nOccurrences]
+*   Track      tracks[nTracks]
+*   uint64_t   nameOffsets[nNames + 1]        name i: names[nameOffsets[i], nameOffsets[i+1])
+*   char       names[nameOffsets[nNames]]
+*/
+class SeedFile {
+public:
+    struct Header {
+        char magic[8];
+        uint64_t nSeeds;
+        uint64_t nNodeIDs;
+        uint64_t nOccurrences;
+        uint64_t nTracks;
+        uint64_t nNames;
+        //! index of the name of genome 0 of the IdentifierMapping, nNames if unknown
+        uint64_t referenceGenomeName;
+    };
+    struct Occurrence {
+        //! index into the track table of the file
+        uint32_t track;
+        uint32_t padding;
+        uint64_t position;
+    };
+    struct Track {
+        //! indices into the name table of the file
+        uint32_t genomeName;
+        uint32_t sequenceName;
+        uint32_t reverse_strand;
+        uint32_t padding;
+    };
+    //! a seed, pointing into the mapped file
+    struct Seed {
+        MetagraphInterface::NodeID const * nodeIDs;
+        size_t nNodeIDs;
+        Occurrence const * occurrences;
+        size_t nOccurrences;
+    };
+
+    //! collects seeds and writes them as a SeedFile
+    class Writer {
+    public:
+        //! adds a seed as it is passed to SeedExtension::initFirstTip()
+        void add(std::vector<MetagraphInterface::NodeID> const & nodeIDs,
+                 LinkPtr link,
+                 std::shared_ptr<IdentifierMapping const> idMap);
+        //! writes all added seeds to path, returns false if the file cannot be written
+        bool write(std::string const & path) const;
+
+        size_t nSeeds() const {
+            return nodeIDOffsets.size() - 1;
+        }
+
+    private:
+        uint32_t nameIndex(std::string const & name);
+
+        std::vector<uint64_t> nodeIDOffsets{0};
+        std::vector<uint64_t> occurrenceOffsets{0};
+        std::vector<uint64_t> nodeIDs;
+        std::vector<Occurrence> occurrences;
+        std::vector<Track> tracks;
+        std::vector<std::string> names;
+        std::unordered_map<std::string, uint32_t> nameIndices;
+        std::map<std::tuple<uint32_t, uint32_t, bool>, uint32_t> trackIndices;
+        int64_t referenceGenomeName = -1;
+    };
+
+    //! maps the file at path
+    /*! throws std::runtime_error if it cannot be mapped or is not a valid SeedFile,
+     * i.e. if a section does not fit into the file or an offset or a track index of
+     * a seed is out of range, so seed() and annoKey() can trust the file
+     */
+    SeedFile(std::string const & path);
+    ~SeedFile();
+    SeedFile(SeedFile const &) = delete;
+    SeedFile & operator=(SeedFile const &) = delete;
+
+    size_t size() const {
+        return header->nSeeds;
+    }
+    Seed seed(size_t seedIndex) const {
+        return Seed{nodeIDs + nodeIDOffsets[seedIndex],
+                    nodeIDOffsets[seedIndex + 1] - nodeIDOffsets[seedIndex],
+                    occurrences + occurrenceOffsets[seedIndex],
+                    occurrenceOffsets[seedIndex + 1] - occurrenceOffsets[seedIndex]};
+    }
+    //! returns the occurrence as annotation of the graph in interned form
+    ColorClasses::AnnoKey annoKey(Occurrence const & occurrence) const {
+        return ColorClasses::AnnoKey{trackIDs[occurrence.track], occurrence.position};
+    }
+
+    //! the interned (see ColorClasses::genomeID()) genome 0 of the IdentifierMapping of the seeds
+    uint32_t referenceGenomeID() const {
+        return referenceGenome;
+    }
+
+    static constexpr char magic[8] = {'S', 'E', 'E', 'D', 'F', 'I', 'L', '2'};
+
+private:
+    std::string name(uint64_t nameIndex) const;
+
+    std::string path;
+    void * data;
+    size_t fileSize;
+    Header const * header;
+    uint64_t const * nodeIDOffsets;
+    uint64_t const * occurrenceOffsets;
+    MetagraphInterface::NodeID const * nodeIDs;
+    Occurrence const * occurrences;
+    Track const * tracks;
+    uint64_t const * nameOffsets;
+    char const * names;
+    //! ColorClasses::TrackID of every track of the file
+    std::vector<ColorClasses::TrackID> trackIDs;
+    uint32_t referenceGenome;
+};
+
+#endif //_SeedFile_HPP_
@@ -0,0 +1,58 @@
+#include "ThreadPool.hpp"
+
+#include <functional>
+#include <mutex>
+#include <thread>
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        isStopping = true;
+    }
+    hasTasks.notify_all();
+    for (auto & thread : threads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::run(size_t nTasks_, std::function<void(size_t)> const & work_) {
+    std::lock_guard<std::mutex> runLock(runMutex);
+    std::unique_lock<std::mutex> lock(mutex);
+    while (threads.size() + 1 < nTasks_) {
+        threads.emplace_back(&ThreadPool::workerLoop, this);
+    }
+    work = &work_;
+    nTasks = nTasks_;
+    nextTask = 0;
+    nUnfinished = nTasks_;
+    hasTasks.notify_all();
+    runTasks(lock);
+    isFinished.wait(lock, [this]() { return nUnfinished == 0; });
+    work = nullptr;
+}
+
+void ThreadPool::runTasks(std::unique_lock<std::mutex> & lock) {
+    while (work != nullptr && nextTask < nTasks) {
+        size_t task = nextTask++;
+        auto const & currentWork = *work;
+        lock.unlock();
+        currentWork(task);
+        lock.lock();
+        if (--nUnfinished == 0) {
+            isFinished.notify_all();
+        }
+    }
+}
+
+void ThreadPool::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        hasTasks.wait(lock, [this]() {
+            return isStopping || (work != nullptr && nextTask < nTasks);
+        });
+        if (isStopping) {
+            return;
+        }
+        runTasks(lock);
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef _ThreadPool_HPP_
+#define _ThreadPool_HPP_
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* Threads that are started once and then run the chunks of AllTips::forEachChunk()
+* \details A parallel extension step calls forEachChunk() several times, so starting a
+* thread for every chunk (std::async) would cost more than the chunks of a small frontier.
+* The threads wait for the next run(), more are started when a run has more tasks
+* than threads. One run() at a time, the calls of several threads are serialized.
+*/
+class ThreadPool {
+public:
+    ThreadPool() = default;
+    //! stops and joins the threads
+    ~ThreadPool();
+    ThreadPool(ThreadPool const &) = delete;
+    ThreadPool & operator=(ThreadPool const &) = delete;
+
+    //! calls work(task) for every task in [0, nTasks) and returns when all are done
+    /*! the calling thread runs tasks as well, so nTasks - 1 threads are used */
+    void run(size_t nTasks, std::function<void(size_t)> const & work);
+
+    size_t nThreads() const {
+        return threads.size();
+    }
+
+private:
+    //! runs tasks of the current run until there are none left, with lock held on entry and exit
+    void runTasks(std::unique_lock<std::mutex> & lock);
+    void workerLoop();
+
+    std::vector<std::thread> threads;
+    //! serializes run()
+    std::mutex runMutex;
+    //! guards the state of the current run below
+    std::mutex mutex;
+    std::condition_variable hasTasks;
+    std::condition_variable isFinished;
+    std::function<void(size_t)> const * work = nullptr;
+    size_t nTasks = 0;
+    size_t nextTask = 0;
+    size_t nUnfinished = 0;
+    bool isStopping = false;
+};
+
+#endif //_ThreadPool_HPP_
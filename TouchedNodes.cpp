@@ -0,0 +1,160 @@
+#include "TouchedNodes.hpp"
+
+#include "ColorClasses.hpp"
+#include "SeedExtension.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+TouchedNodes::TouchedNodes(size_t seedIndex_, uint64_t seedHash_, SeedExtension const & seedExtension):
+                           seedIndex{seedIndex_},
+                           seedHash{seedHash_} {
+    // the later steps only hold annotations of these tracks
+    for (auto const & tip : seedExtension.tipsHistory.front()->tips) {
+        for (auto const & anno : tip.second->annotations) {
+            tracks.push_back(anno.first.track);
+        }
+    }
+    std::sort(tracks.begin(), tracks.end());
+    tracks.erase(std::unique(tracks.begin(), tracks.end()), tracks.end());
+
+    for (auto nodeID : seedExtension.touchedNodes) {
+        nodes.push_back(Node{nodeID,
+                             seedExtension.graph.getKmer(nodeID),
+                             nAnnotationsInTracks(seedExtension.graph, nodeID, tracks)});
+    }
+    std::sort(nodes.begin(), nodes.end(), [](Node const & a, Node const & b) {
+        return a.nodeID < b.nodeID;
+    });
+}
+
+size_t TouchedNodes::nAnnotationsInTracks(NodeCache const & graph,
+                                          MetagraphInterface::NodeID nodeID,
+                                          std::vector<ColorClasses::TrackID> const & tracks) {
+    size_t n = 0;
+    for (auto const & anno : graph.getColors(nodeID).annotations) {
+        if (std::binary_search(tracks.begin(), tracks.end(), anno.track)) {
+            n++;
+        }
+    }
+    return n;
+}
+
+bool TouchedNodes::isChanged(NodeCache const & graph, uint64_t currentSeedHash) const {
+    if (currentSeedHash != seedHash) {
+        return true;
+    }
+    // node IDs start at 1
+    for (auto const & node : nodes) {
+        if (node.nodeID > graph.numNodes() ||
+            graph.getKmer(node.nodeID) != node.kmer ||
+            nAnnotationsInTracks(graph, node.nodeID, tracks) != node.nAnnotations) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// tracks are written by name, bc their ids are only valid in one process
+std::string TouchedNodes::toString() const {
+    std::ostringstream line;
+    line << seedIndex << '\t'
+         << seedHash << '\t'
+         << tracks.size() << '\t';
+    for (auto trackID : tracks) {
+        auto track = ColorClasses::track(trackID);
+        line << track.genome << '\t'
+             << track.sequence << '\t'
+             << track.reverse_strand << '\t';
+    }
+    line << nodes.size() << '\t';
+    for (auto const & node : nodes) {
+        line << node.nodeID << '\t'
+             << node.kmer << '\t'
+             << node.nAnnotations << '\t';
+    }
+    line << "end";
+    return line.str();
+}
+
+// names may contain spaces, so the fields are split at tabs only
+bool TouchedNodes::fromString(std::string const & line, TouchedNodes & touched) {
+    std::istringstream fields(line);
+    auto next = [&fields](std::string & field) {
+        return bool(std::getline(fields, field, '\t'));
+    };
+    auto nextNumber = [&next](uint64_t & number) {
+        std::string field;
+        if (!next(field) || field.empty() ||
+            field.find_first_not_of("0123456789") != std::string::npos) {
+            return false;
+        }
+        number = std::stoull(field);
+        return true;
+    };
+    uint64_t seedIndex, nTracks, nNodes;
+    if (!nextNumber(seedIndex) || !nextNumber(touched.seedHash) || !nextNumber(nTracks)) {
+        return false;
+    }
+    touched.seedIndex = seedIndex;
+    touched.tracks.clear();
+    for (uint64_t i = 0; i < nTracks; i++) {
+        MetagraphInterface::NodeAnnotation anno;
+        uint64_t reverse;
+        if (!next(anno.genome) || !next(anno.sequence) || !nextNumber(reverse)) {
+            return false;
+        }
+        anno.reverse_strand = reverse;
+        anno.bin_idx = 0;
+        touched.tracks.push_back(ColorClasses::trackID(anno));
+    }
+    // the ids of this process can be ordered differently
+    std::sort(touched.tracks.begin(), touched.tracks.end());
+    touched.nodes.clear();
+    if (!nextNumber(nNodes)) {
+        return false;
+    }
+    for (uint64_t i = 0; i < nNodes; i++) {
+        Node node;
+        uint64_t nodeID, nAnnotations;
+        if (!nextNumber(nodeID) || !next(node.kmer) || !nextNumber(nAnnotations)) {
+            return false;
+        }
+        node.nodeID = nodeID;
+        node.nAnnotations = nAnnotations;
+        touched.nodes.push_back(node);
+    }
+    std::string end;
+    return(next(end) && end == "end");
+}
+
+bool TouchedNodes::writeAll(std::string const & path, std::vector<TouchedNodes> const & records) {
+    std::ofstream outf(path);
+    for (auto const & touched : records) {
+        outf << touched.toString() << '\n';
+    }
+    outf.close();
+    return(!outf.fail());
+}
+
+bool TouchedNodes::readAll(std::string const & path, std::vector<TouchedNodes> & records) {
+    std::ifstream inf(path);
+    if (!inf) {
+        std::cout << "cannot open touched nodes file " << path << '\n';
+        return false;
+    }
+    std::string line;
+    while (std::getline(inf, line)) {
+        TouchedNodes touched;
+        if (!TouchedNodes::fromString(line, touched)) {
+            std::cout << "invalid line in touched nodes file " << path << ": " << line << '\n';
+            return false;
+        }
+        records.push_back(touched);
+    }
+    return true;
+}
@@ -0,0 +1,61 @@
+#ifndef _TouchedNodes_HPP_
+#define _TouchedNodes_HPP_
+
+#include "ColorClasses.hpp"
+#include "MetagraphInterface.h"
+#include "NodeCache.hpp"
+#include "SeedExtension.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* The nodes and annotation tracks the extension of one seed depended on
+* \details Every node that was a tip of the seed (see SeedExtension::touchedNodes) is stored
+* with its kmer and its number of annotations in the tracks of the seed, i.e. the tracks of
+* its first AllTips. An annotation of another track never joins the bundles of the seed,
+* so as long as the seed (see seedHash) and these numbers stay the same, extending the seed
+* again gives the same result. This holds when genomes are added to the graph and the
+* annotations of the genomes that were there stay the same, which
+* MultiSeedExtension::runIncremental() uses to extend only the seeds whose nodes gained
+* annotations of their tracks.
+* Node IDs are compared by their kmer, if the graph renumbered the nodes every seed is changed.
+*/
+struct TouchedNodes {
+    struct Node {
+        MetagraphInterface::NodeID nodeID;
+        std::string kmer;
+        size_t nAnnotations;
+    };
+
+    TouchedNodes():seedIndex{0}, seedHash{0} {}
+    //! collects the nodes of the finished extension of the seed with index seedIndex_
+    /*! the extension has to be made with SeedExtension::recordTouchedNodes */
+    TouchedNodes(size_t seedIndex_, uint64_t seedHash_, SeedExtension const & seedExtension);
+
+    //! returns true if extending the seed on graph can give another result than before
+    /*! currentSeedHash is the seedHash of the seed now, see MultiSeedExtension::seedHash() */
+    bool isChanged(NodeCache const & graph, uint64_t currentSeedHash) const;
+    //! returns the number of annotations of the node in tracks, which has to be sorted
+    static size_t nAnnotationsInTracks(NodeCache const & graph,
+                                       MetagraphInterface::NodeID nodeID,
+                                       std::vector<ColorClasses::TrackID> const & tracks);
+
+    //! one line, tab separated, without '\n', see ExtensionResult::toString()
+    std::string toString() const;
+    //! parses a line written by toString(), returns false if the line is incomplete
+    static bool fromString(std::string const & line, TouchedNodes & touched);
+    //! writes the records one per line to path, returns false if the file cannot be written
+    static bool writeAll(std::string const & path, std::vector<TouchedNodes> const & records);
+    //! appends the records in path to records, returns false if the file cannot be read or a line is invalid
+    static bool readAll(std::string const & path, std::vector<TouchedNodes> & records);
+
+    size_t seedIndex;
+    //! identifies the node IDs and occurrences of the seed
+    uint64_t seedHash;
+    //! sorted
+    std::vector<ColorClasses::TrackID> tracks;
+    std::vector<Node> nodes;
+};
+
+#endif //_TouchedNodes_HPP_
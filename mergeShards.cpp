@@ -0,0 +1,24 @@
+#include "ExtensionResult.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+//! combines the result files of the shards of a run (see MultiSeedExtension::shard())
+//! into the result file of a run in a single process
+int main(int argc, char ** argv) {
+    if (argc < 3) {
+        std::cout << "usage: " << argv[0] << " <merged result file> <shard result file>..." << '\n';
+        return 1;
+    }
+    std::vector<std::string> paths(argv + 2, argv + argc);
+    std::vector<ExtensionResult> merged;
+    if (!ExtensionResult::merge(paths, merged)) {
+        return 1;
+    }
+    if (!ExtensionResult::writeAll(argv[1], merged)) {
+        std::cout << "cannot write " << argv[1] << '\n';
+        return 1;
+    }
+    return 0;
+}
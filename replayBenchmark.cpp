@@ -0,0 +1,61 @@
+#include "ExtensionResult.hpp"
+#include "NodeCache.hpp"
+#include "SeedExtension.hpp"
+#include "SeedFile.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+//! extends all seeds of a SeedFile on the graph of a trace (see NodeCache::record())
+//! and reports the time, no metagraph is needed
+int main(int argc, char ** argv) {
+    if (argc < 6) {
+        std::cout << "usage: " << argv[0]
+                  << " <trace> <seed file> <xdrop> <binsize> <sufficientMaxScore> [<result file>]" << '\n';
+        return 1;
+    }
+    auto loadStart = std::chrono::steady_clock::now();
+    NodeCache graph = NodeCache::fromTrace(argv[1]);
+    std::unique_ptr<SeedFile const> seedFile;
+    try {
+        seedFile = std::make_unique<SeedFile const>(argv[2]);
+    } catch (std::runtime_error const & error) {
+        std::cout << error.what() << '\n';
+        return 1;
+    }
+    uint64_t xdrop = std::stoull(argv[3]);
+    size_t binsize = std::stoull(argv[4]);
+    size_t sufficientMaxScore = std::stoull(argv[5]);
+    auto extendStart = std::chrono::steady_clock::now();
+
+    SeedExtension seedExtension(graph, xdrop, binsize);
+    std::vector<ExtensionResult> results;
+    for (size_t i = 0; i < seedFile->size(); i++) {
+        seedExtension.initFirstTip(*seedFile, i, nullptr);
+        seedExtension.extend(sufficientMaxScore);
+        results.push_back(ExtensionResult(i, seedExtension));
+        // the cache has the capacity of the recorded run
+        graph.trim();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    std::chrono::duration<double> loadTime = extendStart - loadStart;
+    std::chrono::duration<double> extendTime = end - extendStart;
+    // a run that differs from the recorded one (e.g. another order of seeds) is no faithful replay
+    std::cout << "graph queries: " << graph.nMisses() << '\n'
+              << "queries that differ from the trace: " << graph.nReplayMismatches() << '\n'
+              << "seeds: " << seedFile->size() << '\n'
+              << "load time [s]: " << loadTime.count() << '\n'
+              << "extension time [s]: " << extendTime.count() << '\n'
+              << "seeds per second: " << seedFile->size() / extendTime.count() << '\n';
+    // to compare the results of two versions of the engine
+    if (argc > 6 && !ExtensionResult::writeAll(argv[6], results)) {
+        std::cout << "cannot write " << argv[6] << '\n';
+        return 1;
+    }
+    return 0;
+}
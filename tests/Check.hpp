@@ -0,0 +1,46 @@
+#ifndef _Check_HPP_
+#define _Check_HPP_
+
+#include "ExtensionResult.hpp"
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+//! number of failed checks of the test program, its main returns nFailedChecks != 0
+inline size_t nFailedChecks = 0;
+
+//! reports what if condition is false
+inline void check(bool condition, std::string const & what) {
+    if (!condition) {
+        std::cout << "failed: " << what << '\n';
+        nFailedChecks++;
+    }
+}
+
+//! the fields of a result that every way to extend a seed has to agree on
+/*! i.e. without peakMemoryUsage, which depends on how many steps a history entry holds */
+inline std::string summary(ExtensionResult const & result) {
+    std::ostringstream line;
+    line << result.seedIndex << ' '
+         << result.totalScore << ' '
+         << result.maxSteps << ' '
+         << result.maxUpstreamSteps << ' '
+         << result.nAnnotations << ' '
+         << result.nUpstreamAnnotations << ' '
+         << result.truncated;
+    return line.str();
+}
+
+//! checks that two runs of the same seeds give the same results
+inline void checkSameResults(std::vector<ExtensionResult> const & expected,
+                             std::vector<ExtensionResult> const & results,
+                             std::string const & what) {
+    check(results.size() == expected.size(), what + ": number of results");
+    for (size_t i = 0; i < expected.size() && i < results.size(); i++) {
+        check(summary(results[i]) == summary(expected[i]),
+              what + ": " + summary(results[i]) + " instead of " + summary(expected[i]));
+    }
+}
+
+#endif //_Check_HPP_
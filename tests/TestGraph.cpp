@@ -0,0 +1,184 @@
+#include "TestGraph.hpp"
+
+#include "GraphTrace.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <tuple>
+
+TestGraph::TestGraph(std::vector<Genome> const & genomes_, size_t k_, size_t binsize_, bool withReverseStrands):
+                     genomes{genomes_},
+                     k{k_},
+                     binsize{binsize_} {
+    for (auto const & genome : genomes) {
+        auto const & sequence = genome.sequence;
+        for (size_t position = 0; position + k <= sequence.size(); position++) {
+            MetagraphInterface::NodeAnnotation anno;
+            anno.genome = genome.name;
+            anno.sequence = "seq";
+            anno.reverse_strand = false;
+            anno.bin_idx = position / binsize * binsize;
+            annotations[addKmer(sequence.substr(position, k))].push_back(anno);
+            if (withReverseStrands) {
+                anno.reverse_strand = true;
+                annotations[addKmer(reverseComplement(sequence.substr(position, k)))].push_back(anno);
+            }
+        }
+    }
+    // a kmer that occurs twice in a bin has one annotation
+    for (auto & [nodeID, annos] : annotations) {
+        auto key = [](MetagraphInterface::NodeAnnotation const & anno) {
+            return std::make_tuple(anno.genome, anno.sequence, anno.reverse_strand, anno.bin_idx);
+        };
+        std::sort(annos.begin(), annos.end(), [&](auto const & a, auto const & b) {
+            return key(a) < key(b);
+        });
+        annos.erase(std::unique(annos.begin(), annos.end(), [&](auto const & a, auto const & b) {
+            return key(a) == key(b);
+        }), annos.end());
+    }
+}
+
+MetagraphInterface::NodeID TestGraph::addKmer(std::string const & kmer) {
+    auto found = nodeIDs.insert({kmer, kmers.size()});
+    if (found.second) {
+        kmers.push_back(kmer);
+    }
+    return found.first->second;
+}
+
+MetagraphInterface::NodeID TestGraph::nodeID(std::string const & kmer) const {
+    auto found = nodeIDs.find(kmer);
+    return found == nodeIDs.end() ? 0 : found->second;
+}
+
+NodeCache TestGraph::nodeCache(std::string const & path) const {
+    {
+        GraphTrace trace(path, k, kmers.size() - 1, NodeCache::defaultCapacity);
+        for (MetagraphInterface::NodeID nodeID = 1; nodeID < kmers.size(); nodeID++) {
+            std::vector<MetagraphInterface::NodeID> outgoing, incoming;
+            for (char base : std::string("ACGT")) {
+                auto next = this->nodeID(kmers[nodeID].substr(1) + base);
+                if (next != 0) {
+                    outgoing.push_back(next);
+                }
+                auto previous = this->nodeID(base + kmers[nodeID].substr(0, k - 1));
+                if (previous != 0) {
+                    incoming.push_back(previous);
+                }
+            }
+            trace.recordNeighbours(GraphTrace::outgoing, nodeID, outgoing);
+            trace.recordNeighbours(GraphTrace::incoming, nodeID, incoming);
+            trace.recordAnnotation(nodeID, annotations.at(nodeID));
+            trace.recordKmer(nodeID, kmers[nodeID]);
+        }
+        trace.flush();
+    }
+    return NodeCache::fromTrace(path);
+}
+
+TestGraph::Seed TestGraph::seedAt(size_t position) const {
+    auto kmer = genomes[0].sequence.substr(position, k);
+    Seed seed;
+    seed.nodeIDs.push_back(nodeID(kmer));
+    for (size_t i = 0; i < genomes.size(); i++) {
+        if (genomes[i].sequence.size() >= position + k && genomes[i].sequence.substr(position, k) == kmer) {
+            seed.occurrences.push_back({i, position / binsize * binsize, false});
+        }
+    }
+    return seed;
+}
+
+std::vector<TestGraph::Seed> TestGraph::seeds(size_t step) const {
+    std::vector<Seed> seeds;
+    for (size_t position = 0; position + k <= genomes[0].sequence.size(); position += step) {
+        auto seed = seedAt(position);
+        if (seed.occurrences.size() >= 2) {
+            seeds.push_back(seed);
+        }
+    }
+    return seeds;
+}
+
+// see the layout in SeedFile.hpp, names are: "seq", then the genomes
+bool TestGraph::writeSeedFile(std::string const & path, std::vector<Seed> const & seeds) const {
+    std::vector<uint64_t> nodeIDOffsets{0}, occurrenceOffsets{0}, fileNodeIDs;
+    std::vector<SeedFile::Occurrence> occurrences;
+    std::vector<SeedFile::Track> tracks;
+    for (size_t i = 0; i < genomes.size(); i++) {
+        tracks.push_back(SeedFile::Track{uint32_t(i + 1), 0, 0, 0});
+        tracks.push_back(SeedFile::Track{uint32_t(i + 1), 0, 1, 0});
+    }
+    for (auto const & seed : seeds) {
+        fileNodeIDs.insert(fileNodeIDs.end(), seed.nodeIDs.begin(), seed.nodeIDs.end());
+        nodeIDOffsets.push_back(fileNodeIDs.size());
+        for (auto const & [genome, position, reverse] : seed.occurrences) {
+            occurrences.push_back(SeedFile::Occurrence{uint32_t(2 * genome + reverse), 0, position});
+        }
+        occurrenceOffsets.push_back(occurrences.size());
+    }
+    std::vector<std::string> names{"seq"};
+    for (auto const & genome : genomes) {
+        names.push_back(genome.name);
+    }
+    std::vector<uint64_t> nameOffsets{0};
+    for (auto const & name : names) {
+        nameOffsets.push_back(nameOffsets.back() + name.size());
+    }
+
+    SeedFile::Header header{};
+    std::memcpy(header.magic, SeedFile::magic, sizeof(SeedFile::magic));
+    header.nSeeds = seeds.size();
+    header.nNodeIDs = fileNodeIDs.size();
+    header.nOccurrences = occurrences.size();
+    header.nTracks = tracks.size();
+    header.nNames = names.size();
+    header.referenceGenomeName = 1;
+    std::ofstream outf(path, std::ios::binary);
+    auto writeVector = [&outf](auto const & vec) {
+        outf.write(reinterpret_cast<char const *>(vec.data()),
+                   vec.size() * sizeof(typename std::decay_t<decltype(vec)>::value_type));
+    };
+    outf.write(reinterpret_cast<char const *>(&header), sizeof(header));
+    writeVector(nodeIDOffsets);
+    writeVector(occurrenceOffsets);
+    writeVector(fileNodeIDs);
+    writeVector(occurrences);
+    writeVector(tracks);
+    writeVector(nameOffsets);
+    for (auto const & name : names) {
+        outf.write(name.data(), name.size());
+    }
+    return(bool(outf));
+}
+
+std::string TestGraph::randomSequence(size_t length, unsigned seed) {
+    std::mt19937 random(seed);
+    std::string sequence;
+    for (size_t i = 0; i < length; i++) {
+        sequence += "ACGT"[random() % 4];
+    }
+    return sequence;
+}
+
+std::string TestGraph::mutated(std::string const & sequence, double rate, unsigned seed) {
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<double> uniform(0, 1);
+    std::string mutatedSequence = sequence;
+    for (auto & base : mutatedSequence) {
+        if (uniform(random) < rate) {
+            base = "ACGT"[random() % 4];
+        }
+    }
+    return mutatedSequence;
+}
+
+std::string TestGraph::reverseComplement(std::string const & sequence) {
+    std::string reverse(sequence.rbegin(), sequence.rend());
+    for (auto & base : reverse) {
+        base = base == 'A' ? 'T' : base == 'C' ? 'G' : base == 'G' ? 'C' : 'A';
+    }
+    return reverse;
+}
@@ -0,0 +1,70 @@
+#ifndef _TestGraph_HPP_
+#define _TestGraph_HPP_
+
+#include "MetagraphInterface.h"
+#include "NodeCache.hpp"
+#include "SeedFile.hpp"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+/* A small graph of genome strings for the tests, which need no metagraph
+* \details Every genome has one sequence named "seq". The kmer at position p of a
+* sequence has the annotation (genome, "seq", forward, p / binsize * binsize). With
+* withReverseStrands the reverse complements of the sequences are added as well, their
+* kmers are annotated on the reverse strand with the bin of the kmer on the forward strand.
+* Node IDs start at 1 in the order in which the kmers first occur.
+* The graph is written as a GraphTrace and served by NodeCache::fromTrace(), seeds are
+* written as a SeedFile.
+*/
+class TestGraph {
+public:
+    struct Genome {
+        std::string name;
+        std::string sequence;
+    };
+    //! a seed, see SeedFile::Seed
+    struct Seed {
+        std::vector<MetagraphInterface::NodeID> nodeIDs;
+        //! (genome index, bin_idx, reverse_strand)
+        std::vector<std::tuple<size_t, uint64_t, bool>> occurrences;
+    };
+
+    TestGraph(std::vector<Genome> const & genomes_, size_t k_, size_t binsize_, bool withReverseStrands);
+
+    //! writes the graph as a trace to path and returns a NodeCache on it
+    NodeCache nodeCache(std::string const & path) const;
+    //! returns the node of kmer, 0 if it is not in the graph
+    MetagraphInterface::NodeID nodeID(std::string const & kmer) const;
+    //! the seed of the kmer at position of genome 0, with an occurrence in every genome
+    //! that has the same kmer at position
+    Seed seedAt(size_t position) const;
+    //! the seeds of all kmers of genome 0 at every step positions that occur in two genomes
+    std::vector<Seed> seeds(size_t step) const;
+    //! writes seeds to path as a SeedFile, returns false if it cannot be written
+    bool writeSeedFile(std::string const & path, std::vector<Seed> const & seeds) const;
+
+    //! a random sequence of A, C, G and T
+    static std::string randomSequence(size_t length, unsigned seed);
+    //! sequence with every base replaced by a random base with probability rate
+    static std::string mutated(std::string const & sequence, double rate, unsigned seed);
+    static std::string reverseComplement(std::string const & sequence);
+
+    std::vector<Genome> genomes;
+    size_t k;
+    size_t binsize;
+
+private:
+    MetagraphInterface::NodeID addKmer(std::string const & kmer);
+
+    std::map<std::string, MetagraphInterface::NodeID> nodeIDs;
+    //! kmers[nodeID], kmers[0] is unused
+    std::vector<std::string> kmers{""};
+    std::map<MetagraphInterface::NodeID, std::vector<MetagraphInterface::NodeAnnotation>> annotations;
+};
+
+#endif //_TestGraph_HPP_
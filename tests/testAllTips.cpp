@@ -0,0 +1,84 @@
+#include "Check.hpp"
+#include "TestGraph.hpp"
+
+#include "AllTips.hpp"
+#include "ExtensionResult.hpp"
+#include "SeedExtension.hpp"
+#include "SeedFile.hpp"
+#include "ThreadPool.hpp"
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+static size_t const k = 11;
+static size_t const binsize = 10;
+
+//! the node IDs of the last AllTips of both directions in the order of their tips
+static std::vector<MetagraphInterface::NodeID> frontierOrder(SeedExtension const & extension) {
+    std::vector<MetagraphInterface::NodeID> nodeIDs;
+    for (auto const & history : {extension.tipsHistory, extension.upStreamTipsHistory}) {
+        for (auto const & [nodeID, tip] : history.back()->tips) {
+            nodeIDs.push_back(nodeID);
+        }
+        nodeIDs.push_back(0);
+    }
+    return nodeIDs;
+}
+
+static void testThreadPool() {
+    ThreadPool threadPool;
+    for (size_t nTasks : {1, 3, 8, 2}) {
+        std::vector<std::atomic<int>> nCalls(nTasks);
+        threadPool.run(nTasks, [&](size_t task) {
+            nCalls[task]++;
+        });
+        bool isEveryTaskRunOnce = true;
+        for (auto const & n : nCalls) {
+            isEveryTaskRunOnce = isEveryTaskRunOnce && n == 1;
+        }
+        check(isEveryTaskRunOnce, "every task runs once with " + std::to_string(nTasks) + " tasks");
+    }
+    check(threadPool.nThreads() == 7, "threads are reused");
+}
+
+// every step in parallel gives the same results and order of tips as the serial steps
+static void testParallelSteps() {
+    std::string ancestor = TestGraph::randomSequence(500, 1);
+    std::vector<TestGraph::Genome> genomes;
+    for (unsigned i = 0; i < 8; i++) {
+        genomes.push_back({"genome" + std::to_string(i), i == 0 ? ancestor : TestGraph::mutated(ancestor, 0.01 * i, i)});
+    }
+    TestGraph testGraph(genomes, k, binsize, false);
+    NodeCache graph = testGraph.nodeCache("testAllTips.trace");
+    testGraph.writeSeedFile("testAllTips.seeds", testGraph.seeds(11));
+    SeedFile seedFile("testAllTips.seeds");
+
+    check(AllTips::nThreads == 1, "parallel steps are off by default");
+    SeedExtension extension(graph, 20, binsize);
+    std::vector<ExtensionResult> expected, results;
+    std::vector<std::vector<MetagraphInterface::NodeID>> expectedOrders, orders;
+    for (size_t i = 0; i < seedFile.size(); i++) {
+        extension.initFirstTip(seedFile, i, nullptr);
+        extension.extend(1000);
+        expected.push_back(ExtensionResult(i, extension));
+        expectedOrders.push_back(frontierOrder(extension));
+    }
+    AllTips::nThreads = 4;
+    AllTips::parallelFrontierSize = 1;
+    for (size_t i = 0; i < seedFile.size(); i++) {
+        extension.initFirstTip(seedFile, i, nullptr);
+        extension.extend(1000);
+        results.push_back(ExtensionResult(i, extension));
+        orders.push_back(frontierOrder(extension));
+    }
+    AllTips::nThreads = 1;
+    checkSameResults(expected, results, "parallel steps");
+    check(orders == expectedOrders, "parallel steps keep the order of the tips");
+}
+
+int main() {
+    testThreadPool();
+    testParallelSteps();
+    return nFailedChecks != 0;
+}
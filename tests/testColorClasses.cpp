@@ -0,0 +1,96 @@
+#include "Check.hpp"
+
+#include "ColorClasses.hpp"
+#include "MetagraphInterface.h"
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+static MetagraphInterface::NodeAnnotation annotation(size_t genome, size_t sequence) {
+    MetagraphInterface::NodeAnnotation anno;
+    anno.genome = "genome" + std::to_string(genome);
+    anno.sequence = "seq" + std::to_string(sequence);
+    anno.reverse_strand = sequence % 2 == 1;
+    anno.bin_idx = 0;
+    return anno;
+}
+
+// tracks are interned and read by several threads, more than fit into one chunk of the table
+static void testConcurrentTracks() {
+    size_t const nThreads = 4;
+    std::vector<int> isCorrect(nThreads, 1);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < nThreads; t++) {
+        threads.emplace_back([t, &isCorrect]() {
+            for (size_t genome = 0; genome < 100; genome++) {
+                for (size_t sequence = 0; sequence < 60; sequence++) {
+                    // every thread interns the tracks in another order
+                    auto anno = annotation((genome + 25 * t) % 100, sequence);
+                    auto track = ColorClasses::track(ColorClasses::trackID(anno));
+                    isCorrect[t] = isCorrect[t] && track.genome == anno.genome && track.sequence == anno.sequence
+                                   && track.reverse_strand == anno.reverse_strand
+                                   && track.genomeID == ColorClasses::genomeID(anno.genome);
+                }
+            }
+        });
+    }
+    for (auto & thread : threads) {
+        thread.join();
+    }
+    check(std::count(isCorrect.begin(), isCorrect.end(), 1) == (int)nThreads, "tracks read by several threads");
+    check(ColorClasses::trackID(annotation(99, 59)) == ColorClasses::trackID(annotation(99, 59)), "track ids are stable");
+}
+
+// more pairs of classes than sharedTracks() caches
+static void testSharedTracks() {
+    std::vector<ColorClasses::NodeColors> colors;
+    for (size_t c = 0; c < 300; c++) {
+        std::vector<MetagraphInterface::NodeAnnotation> annotations;
+        for (size_t genome = 0; genome < 10; genome++) {
+            if ((c >> (genome % 8)) & 1 || genome == c % 10) {
+                annotations.push_back(annotation(genome, c % 3));
+            }
+        }
+        colors.push_back(ColorClasses::nodeColors(annotations));
+    }
+    check(ColorClasses::nClasses() > 200, "the classes are distinct");
+    size_t nWrong = 0;
+    for (size_t repeat = 0; repeat < 2; repeat++) {
+        for (auto const & from : colors) {
+            for (auto const & to : colors) {
+                auto const & shared = ColorClasses::sharedTracks(from.colorClass, to.colorClass);
+                for (size_t i = 0; i < to.annotations.size(); i++) {
+                    bool isShared = std::any_of(from.annotations.begin(), from.annotations.end(),
+                                                [&](auto const & anno) {
+                        return anno.track == to.annotations[i].track;
+                    });
+                    nWrong += shared[to.trackIndices[i]] != isShared;
+                }
+            }
+        }
+    }
+    check(nWrong == 0, "shared tracks of " + std::to_string(colors.size() * colors.size()) + " pairs");
+}
+
+// neighbouring bins of neighbouring tracks get different hashes
+static void testHashAnnoKey() {
+    std::unordered_set<std::size_t> hashes;
+    size_t nKeys = 0;
+    for (ColorClasses::TrackID track = 0; track < 64; track++) {
+        for (uint64_t bin = 0; bin < 64 * 31; bin += 31) {
+            hashes.insert(ColorClasses::HashAnnoKey()(ColorClasses::AnnoKey{track, bin}));
+            nKeys++;
+        }
+    }
+    check(hashes.size() == nKeys, "no hash collisions of neighbouring annotations");
+}
+
+int main() {
+    testConcurrentTracks();
+    testSharedTracks();
+    testHashAnnoKey();
+    return nFailedChecks != 0;
+}
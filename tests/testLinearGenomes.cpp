@@ -0,0 +1,143 @@
+#include "Check.hpp"
+#include "TestGraph.hpp"
+
+#include "ColorClasses.hpp"
+#include "ExtensionResult.hpp"
+#include "LinearGenomes.hpp"
+#include "SeedExtension.hpp"
+#include "SeedFile.hpp"
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+static size_t const k = 11;
+static size_t const binsize = 10;
+
+static std::string writeFasta(std::string const & genome, std::string const & sequence) {
+    std::string path = "testLinearGenomes." + genome + ".fa";
+    std::ofstream outf(path);
+    outf << ">seq description\n" << sequence << '\n';
+    return path;
+}
+
+static LinearGenomes::Locus locate(LinearGenomes const & linearGenomes,
+                                   std::string const & genome,
+                                   std::string const & sequence,
+                                   size_t position) {
+    MetagraphInterface::NodeAnnotation anno;
+    anno.genome = genome;
+    anno.sequence = "seq";
+    anno.reverse_strand = false;
+    anno.bin_idx = position / binsize * binsize;
+    LinearGenomes::Locus locus;
+    bool isFound = linearGenomes.locate(ColorClasses::annoKey(anno), sequence.substr(position, k), locus);
+    check(isFound && locus.position == position, genome + ": locate kmer at " + std::to_string(position));
+    return locus;
+}
+
+// the steps at the ends of the sequences and at invalid bases
+static void testSyncedSteps() {
+    std::string plain = TestGraph::randomSequence(200, 1);
+    std::string withN = TestGraph::randomSequence(20, 2) + 'N' + TestGraph::randomSequence(30, 3);
+    if (!LinearGenomes::build({{"plain", writeFasta("plain", plain)}, {"withN", writeFasta("withN", withN)}},
+                              "testLinearGenomes.bin")) {
+        check(false, "build linear genomes");
+        return;
+    }
+    LinearGenomes linearGenomes("testLinearGenomes.bin", k, binsize);
+
+    auto last = locate(linearGenomes, "plain", plain, plain.size() - k);
+    check(linearGenomes.syncedSteps({last}, false, 5) == 0, "no step downstream of the last kmer");
+    check(linearGenomes.syncedSteps({last}, true, 5) == 5, "steps upstream of the last kmer");
+
+    auto first = locate(linearGenomes, "plain", plain, 0);
+    check(linearGenomes.syncedSteps({first}, true, 5) == 0, "no step upstream of the first kmer");
+
+    auto middle = locate(linearGenomes, "plain", plain, 100);
+    check(linearGenomes.syncedSteps({middle}, false, 1000) == plain.size() - k - 100,
+          "steps downstream up to the last kmer");
+    check(linearGenomes.syncedSteps({middle}, true, 1000) == 100, "steps upstream up to the first kmer");
+    check(linearGenomes.nextBase(middle, false) == plain[100 + k], "next base downstream");
+    check(linearGenomes.nextBase(middle, true) == plain[99], "next base upstream");
+
+    auto beforeN = locate(linearGenomes, "withN", withN, 20 - k);
+    check(linearGenomes.syncedSteps({beforeN}, false, 5) == 0, "no step downstream into an N");
+    auto afterN = locate(linearGenomes, "withN", withN, 21);
+    check(linearGenomes.syncedSteps({afterN}, true, 5) == 0, "no step upstream into an N");
+    auto nearN = locate(linearGenomes, "withN", withN, 5);
+    check(linearGenomes.syncedSteps({nearN}, false, 100) == 20 - k - 5, "steps downstream up to an N");
+}
+
+// the extension with fast forward on the linear genomes is equal to the plain extension
+static void testLinearExtension() {
+    std::string ancestor = TestGraph::randomSequence(600, 4);
+    std::vector<TestGraph::Genome> genomes;
+    std::vector<std::pair<std::string, std::string>> fastas;
+    for (unsigned i = 0; i < 4; i++) {
+        std::string name = "genome" + std::to_string(i);
+        genomes.push_back({name, i == 0 ? ancestor : TestGraph::mutated(ancestor, 0.02 * i, i)});
+        fastas.push_back({name, writeFasta(name, genomes.back().sequence)});
+    }
+    TestGraph testGraph(genomes, k, binsize, false);
+    NodeCache graph = testGraph.nodeCache("testLinearGenomes.trace");
+    testGraph.writeSeedFile("testLinearGenomes.seeds", testGraph.seeds(7));
+    SeedFile seedFile("testLinearGenomes.seeds");
+    if (!LinearGenomes::build(fastas, "testLinearGenomes.bin")) {
+        check(false, "build linear genomes");
+        return;
+    }
+    auto linearGenomes = std::make_shared<LinearGenomes const>("testLinearGenomes.bin", k, binsize);
+
+    SeedExtension plain(graph, 20, binsize);
+    SeedExtension linear(graph, 20, binsize);
+    linear.fastForward = true;
+    linear.linearGenomes = linearGenomes;
+    std::vector<ExtensionResult> expected, results;
+    int nLinearSteps = 0;
+    for (size_t i = 0; i < seedFile.size(); i++) {
+        plain.initFirstTip(seedFile, i, nullptr);
+        plain.extend(1000);
+        expected.push_back(ExtensionResult(i, plain));
+        linear.initFirstTip(seedFile, i, nullptr);
+        linear.extend(1000);
+        results.push_back(ExtensionResult(i, linear));
+        nLinearSteps += linear.nLinearSteps;
+    }
+    check(nLinearSteps > 0, "steps on the linear genomes");
+    checkSameResults(expected, results, "linear genomes");
+}
+
+// fast forward through a long unitig stops at the time budget
+static void testTimeBudget() {
+    std::string genome = TestGraph::randomSequence(3000, 4);
+    // one bin, so no bin transition ends the unitig
+    size_t const oneBin = 10000;
+    TestGraph testGraph({{"genome0", genome}, {"genome1", genome}}, k, oneBin, false);
+    NodeCache graph = testGraph.nodeCache("testTimeBudget.trace");
+    testGraph.writeSeedFile("testTimeBudget.seeds", {testGraph.seedAt(1500)});
+    SeedFile seedFile("testTimeBudget.seeds");
+
+    SeedExtension unlimited(graph, 20, oneBin);
+    unlimited.fastForward = true;
+    unlimited.initFirstTip(seedFile, 0, nullptr);
+    unlimited.extend(1000000);
+    check(unlimited.nStepsMade > 1000, "the unitig is fast forwarded");
+
+    SeedExtension extension(graph, 20, oneBin);
+    extension.fastForward = true;
+    extension.timeBudget = 1e-12;
+    extension.initFirstTip(seedFile, 0, nullptr);
+    extension.extend(1000000);
+    check(extension.truncated, "the time budget is reached");
+    check(extension.nStepsMade < 10, "fast forward stops at the time budget");
+}
+
+int main() {
+    testSyncedSteps();
+    testLinearExtension();
+    testTimeBudget();
+    return nFailedChecks != 0;
+}
@@ -0,0 +1,195 @@
+#include "Check.hpp"
+#include "TestGraph.hpp"
+
+#include "Checkpoint.hpp"
+#include "ExtensionResult.hpp"
+#include "LinearGenomes.hpp"
+#include "MultiSeedExtension.hpp"
+#include "NodeCache.hpp"
+#include "RepeatMask.hpp"
+#include "SeedFile.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+static size_t const k = 11;
+static size_t const binsize = 10;
+static uint64_t const xdrop = 20;
+static size_t const sufficientMaxScore = 1000;
+
+static std::vector<TestGraph::Genome> genomes(size_t nGenomes, unsigned seed) {
+    std::string ancestor = TestGraph::randomSequence(500, seed);
+    std::vector<TestGraph::Genome> genomes;
+    for (unsigned i = 0; i < nGenomes; i++) {
+        genomes.push_back({"genome" + std::to_string(i), i == 0 ? ancestor : TestGraph::mutated(ancestor, 0.02 * i, seed + i)});
+    }
+    return genomes;
+}
+
+static std::vector<MultiSeedExtension::Seed> seedsOf(TestGraph const & testGraph,
+                                                     std::vector<TestGraph::Seed> const & seeds,
+                                                     std::string const & path) {
+    testGraph.writeSeedFile(path, seeds);
+    return MultiSeedExtension::seedsOf(std::make_shared<SeedFile const>(path));
+}
+
+// the result of every seed with the same duplicateKey() as a seed before is copied from that seed
+static void testDuplicates() {
+    TestGraph testGraph(genomes(3, 1), k, binsize, true);
+    NodeCache graph = testGraph.nodeCache("testDuplicates.trace");
+    // the seed at position on the reverse strands
+    auto twinAt = [&testGraph](size_t position) {
+        auto twin = testGraph.seedAt(position);
+        twin.nodeIDs = {testGraph.nodeID(TestGraph::reverseComplement(testGraph.genomes[0].sequence.substr(position, k)))};
+        for (auto & occurrence : twin.occurrences) {
+            std::get<2>(occurrence) = true;
+        }
+        return twin;
+    };
+    std::vector<TestGraph::Seed> seeds;
+    size_t nDuplicates = 0;
+    for (size_t position = 0; position + k <= testGraph.genomes[0].sequence.size(); position += 9) {
+        auto seed = testGraph.seedAt(position);
+        if (seed.occurrences.size() < 2) {
+            continue;
+        }
+        seeds.push_back(seed);
+        // the same seed with a later occurrence on the other strand
+        auto otherStrand = seed;
+        std::get<2>(otherStrand.occurrences.back()) = true;
+        seeds.push_back(otherStrand);
+        seeds.push_back(seed);
+        seeds.push_back(twinAt(position));
+        nDuplicates++;
+    }
+    auto fileSeeds = seedsOf(testGraph, seeds, "testDuplicates.seeds");
+
+    MultiSeedExtension keys(graph, xdrop, binsize, 1);
+    check(keys.duplicateKey(fileSeeds[0]) == keys.duplicateKey(fileSeeds[2]), "a copy of a seed is a duplicate");
+    check(keys.duplicateKey(fileSeeds[0]) != keys.duplicateKey(fileSeeds[1]),
+          "a later occurrence on the other strand is no duplicate");
+    check(keys.duplicateKey(fileSeeds[0]) != keys.duplicateKey(fileSeeds[3]), "the reverse complement is no duplicate");
+
+    // so the extensions end at the genomes and not at sufficientMaxScore
+    size_t const unreachedMaxScore = 1000000;
+    MultiSeedExtension plain(graph, xdrop, binsize, 4);
+    auto expected = plain.run(fileSeeds, unreachedMaxScore);
+    // the strands are not symmetric, so the result of a reverse complement cannot be mirrored
+    bool isMirrored = true;
+    for (size_t i = 0; i < seeds.size(); i += 4) {
+        isMirrored = isMirrored && expected[i].maxSteps == expected[i + 3].maxUpstreamSteps
+                                && expected[i].maxUpstreamSteps == expected[i + 3].maxSteps;
+    }
+    check(!isMirrored, "reverse complements are extended differently");
+    MultiSeedExtension deduplicated(graph, xdrop, binsize, 4);
+    deduplicated.deduplicateSeeds = true;
+    auto results = deduplicated.run(fileSeeds, unreachedMaxScore);
+    check(deduplicated.nCopiedDuplicates == nDuplicates, "every duplicate is copied");
+    checkSameResults(expected, results, "deduplicated seeds");
+}
+
+// a resumed run takes the results from the checkpoint, whose header tells the runs apart
+static void testCheckpoint() {
+    TestGraph testGraph(genomes(3, 2), k, binsize, false);
+    NodeCache graph = testGraph.nodeCache("testCheckpoint.trace");
+    auto seeds = seedsOf(testGraph, testGraph.seeds(9), "testCheckpoint.seeds");
+    std::remove("testCheckpoint.txt");
+
+    MultiSeedExtension first(graph, xdrop, binsize, 4);
+    first.checkpoint = std::make_shared<Checkpoint>("testCheckpoint.txt", 3);
+    auto expected = first.run(seeds, sufficientMaxScore);
+    first.checkpoint = nullptr;
+
+    MultiSeedExtension resumed(graph, xdrop, binsize, 4);
+    resumed.checkpoint = std::make_shared<Checkpoint>("testCheckpoint.txt", 3);
+    checkSameResults(expected, resumed.run(seeds, sufficientMaxScore), "resumed run");
+    check(resumed.extensions.empty(), "a resumed run extends no seed again");
+
+    auto header = resumed.checkpointHeader(seeds, sufficientMaxScore);
+    MultiSeedExtension otherXDrop(graph, xdrop + 1, binsize, 4);
+    check(otherXDrop.checkpointHeader(seeds, sufficientMaxScore) != header, "the header has xdrop");
+    check(resumed.checkpointHeader(seeds, sufficientMaxScore + 1) != header, "the header has sufficientMaxScore");
+    auto otherSeeds = seeds;
+    std::swap(otherSeeds[0], otherSeeds[1]);
+    check(resumed.checkpointHeader(otherSeeds, sufficientMaxScore) != header, "the header has the seeds");
+
+    MultiSeedExtension deduplicated(graph, xdrop, binsize, 4);
+    deduplicated.deduplicateSeeds = true;
+    check(deduplicated.checkpointHeader(seeds, sufficientMaxScore) != header, "the header has deduplicateSeeds");
+
+    std::ofstream fasta("testCheckpoint.fa");
+    fasta << ">seq\n" << testGraph.genomes[0].sequence << '\n';
+    fasta.close();
+    check(LinearGenomes::build({{testGraph.genomes[0].name, "testCheckpoint.fa"}}, "testCheckpoint.linear"),
+          "build linear genomes");
+    MultiSeedExtension linear(graph, xdrop, binsize, 4);
+    linear.linearGenomes = std::make_shared<LinearGenomes const>("testCheckpoint.linear", k, binsize);
+    check(linear.checkpointHeader(seeds, sufficientMaxScore) != header, "the header has linearGenomes");
+
+    // a mask of every node with more than one annotation, see the layout in RepeatMask.hpp
+    RepeatMask::Header maskHeader{};
+    std::memcpy(maskHeader.magic, RepeatMask::magic, sizeof(RepeatMask::magic));
+    maskHeader.numNodes = graph.numNodes();
+    maskHeader.maxAnnotations = 1;
+    std::vector<uint64_t> bits(maskHeader.numNodes / 64 + 1, 0);
+    for (MetagraphInterface::NodeID nodeID = 1; nodeID <= maskHeader.numNodes; nodeID++) {
+        if (graph.getAnnotation(nodeID).size() > 1) {
+            bits[nodeID / 64] |= uint64_t(1) << (nodeID % 64);
+            maskHeader.nRepeatNodes++;
+        }
+    }
+    std::ofstream maskFile("testCheckpoint.mask", std::ios::binary);
+    maskFile.write(reinterpret_cast<char const *>(&maskHeader), sizeof(maskHeader));
+    maskFile.write(reinterpret_cast<char const *>(bits.data()), bits.size() * sizeof(uint64_t));
+    maskFile.close();
+    auto mask = std::make_shared<RepeatMask const>("testCheckpoint.mask");
+    // a new cache, bc the copies of graph share the mask
+    NodeCache maskedGraph = testGraph.nodeCache("testCheckpointMasked.trace");
+    MultiSeedExtension masked(maskedGraph, xdrop, binsize, 4);
+    maskedGraph.setRepeatMask(mask, RepeatMask::skip);
+    auto skipHeader = masked.checkpointHeader(seeds, sufficientMaxScore);
+    check(skipHeader != header, "the header has the repeat mask");
+    maskedGraph.setRepeatMask(mask, RepeatMask::stop);
+    check(masked.checkpointHeader(seeds, sufficientMaxScore) != skipHeader, "the header has the repeat policy");
+}
+
+// an incremental run on a changed graph gives the results of a full run on that graph
+static void testIncremental() {
+    auto before = genomes(3, 3);
+    // genome 2 changes in one region and a genome is added, the node IDs of genome 0 stay the same
+    auto after = before;
+    std::string & changed = after[2].sequence;
+    changed.replace(250, 100, TestGraph::mutated(changed.substr(250, 100), 0.1, 7));
+    after.push_back({"genome3", TestGraph::randomSequence(50, 8) + before[0].sequence.substr(100, 200)});
+    TestGraph testGraphBefore(before, k, binsize, false);
+    TestGraph testGraphAfter(after, k, binsize, false);
+    auto seeds = seedsOf(testGraphBefore, testGraphBefore.seeds(9), "testIncremental.seeds");
+
+    MultiSeedExtension recorded(testGraphBefore.nodeCache("testIncrementalBefore.trace"), xdrop, binsize, 4);
+    recorded.recordTouchedNodes = true;
+    auto previousResults = recorded.run(seeds, sufficientMaxScore);
+    check(recorded.touchedNodes.size() == seeds.size(), "every seed has its touched nodes");
+
+    NodeCache graph = testGraphAfter.nodeCache("testIncrementalAfter.trace");
+    MultiSeedExtension full(graph, xdrop, binsize, 4);
+    auto expected = full.run(seeds, sufficientMaxScore);
+    MultiSeedExtension incremental(graph, xdrop, binsize, 4);
+    auto results = incremental.runIncremental(seeds, sufficientMaxScore, previousResults, recorded.touchedNodes);
+    check(incremental.nKeptResults > 0, "some results are kept");
+    check(incremental.nKeptResults < seeds.size(), "the seeds in the changed region are extended again");
+    check(incremental.touchedNodes.size() == seeds.size(), "every seed has its touched nodes for the next run");
+    checkSameResults(expected, results, "incremental run");
+}
+
+int main() {
+    testDuplicates();
+    testCheckpoint();
+    testIncremental();
+    return nFailedChecks != 0;
+}
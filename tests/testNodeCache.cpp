@@ -0,0 +1,71 @@
+#include "Check.hpp"
+#include "TestGraph.hpp"
+
+#include "ExtensionResult.hpp"
+#include "GraphTrace.hpp"
+#include "NodeCache.hpp"
+#include "SeedExtension.hpp"
+#include "SeedFile.hpp"
+
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+static size_t const k = 11;
+static size_t const binsize = 10;
+static size_t const capacity = 200;
+
+static std::vector<ExtensionResult> extendAll(NodeCache graph, SeedFile const & seedFile) {
+    SeedExtension extension(graph, 20, binsize);
+    std::vector<ExtensionResult> results;
+    for (size_t i = 0; i < seedFile.size(); i++) {
+        extension.initFirstTip(seedFile, i, nullptr);
+        extension.extend(1000);
+        results.push_back(ExtensionResult(i, extension));
+        // no extension step is running
+        graph.trim();
+    }
+    return results;
+}
+
+// a replay has the capacity of the recorded run, so it makes the recorded queries
+static void testReplay() {
+    std::string ancestor = TestGraph::randomSequence(500, 1);
+    std::vector<TestGraph::Genome> genomes;
+    for (unsigned i = 0; i < 4; i++) {
+        genomes.push_back({"genome" + std::to_string(i), i == 0 ? ancestor : TestGraph::mutated(ancestor, 0.02 * i, i)});
+    }
+    TestGraph testGraph(genomes, k, binsize, false);
+    testGraph.writeSeedFile("testNodeCache.seeds", testGraph.seeds(13));
+    SeedFile seedFile("testNodeCache.seeds");
+
+    NodeCache recorded = testGraph.nodeCache("testNodeCache.graph.trace");
+    recorded.setCapacity(capacity);
+    recorded.record("testNodeCache.trace");
+    auto expected = extendAll(recorded, seedFile);
+    recorded.stopRecording();
+
+    GraphTrace::Contents contents;
+    check(GraphTrace::read("testNodeCache.trace", contents), "read the trace");
+    std::set<std::pair<GraphTrace::Query, MetagraphInterface::NodeID>> distinctQueries(contents.queries.begin(),
+                                                                                      contents.queries.end());
+    check(distinctQueries.size() < contents.queries.size(), "nodes fetched again after trim() are in the trace");
+
+    // the capacity is taken from the trace
+    NodeCache replayed = NodeCache::fromTrace("testNodeCache.trace");
+    checkSameResults(expected, extendAll(replayed, seedFile), "replay");
+    check(replayed.nMisses() == recorded.nMisses(), "replay has the misses of the recorded run");
+    check(replayed.nReplayMismatches() == 0, "replay makes the recorded queries");
+
+    NodeCache larger = NodeCache::fromTrace("testNodeCache.trace");
+    larger.setCapacity(NodeCache::defaultCapacity);
+    checkSameResults(expected, extendAll(larger, seedFile), "replay with larger capacity");
+    check(larger.nMisses() < recorded.nMisses(), "a larger cache has fewer misses");
+    check(larger.nReplayMismatches() > 0, "the queries of a larger cache differ from the trace");
+}
+
+int main() {
+    testReplay();
+    return nFailedChecks != 0;
+}
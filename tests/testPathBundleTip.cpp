@@ -0,0 +1,122 @@
+#include "Check.hpp"
+
+#include "AllTips.hpp"
+#include "ColorClasses.hpp"
+#include "PathBundleTip.hpp"
+
+#include <random>
+#include <string>
+#include <unordered_map>
+
+using Scores = std::unordered_map<ColorClasses::AnnoKey, PathBundleTip::Score, ColorClasses::HashAnnoKey>;
+
+// the Score s of a bundle as they were updated one by one before the offsets were lazy
+static void addToScores(Scores & scores, double delta) {
+    for (auto & [anno, score] : scores) {
+        score.currentScore += delta;
+    }
+}
+
+static void updateMaxScores(Scores & scores, uint64_t numberOfExtensionsMade) {
+    for (auto & [anno, score] : scores) {
+        if (score.maxScore <= score.currentScore) {
+            score.maxScore = score.currentScore;
+            score.ageOfMaxScore = numberOfExtensionsMade;
+        }
+    }
+}
+
+static void checkScores(PathBundleTip const & bundle, Scores const & expected, std::string const & what) {
+    check(bundle.annotations.size() == expected.size(), what + ": number of annotations");
+    uint64_t const xdrop = 20;
+    bool isDroppable = false;
+    for (auto const & [anno, score] : expected) {
+        auto found = bundle.annotations.find(anno);
+        if (found == bundle.annotations.end()) {
+            check(false, what + ": annotation is missing");
+            continue;
+        }
+        auto actual = bundle.effectiveScore(found->second);
+        check(actual.currentScore == score.currentScore && actual.maxScore == score.maxScore
+              && actual.ageOfMaxScore == score.ageOfMaxScore,
+              what + ": score " + std::to_string(actual.currentScore) + " " + std::to_string(actual.maxScore)
+              + " instead of " + std::to_string(score.currentScore) + " " + std::to_string(score.maxScore));
+        isDroppable = isDroppable || score.currentScore < score.maxScore - xdrop;
+    }
+    check(!(isDroppable && bundle.cannotBeDropped(xdrop)), what + ": droppable annotation is not checked");
+}
+
+static PathBundleTip::Score initialScore() {
+    return PathBundleTip::Score{0, 0, 0, 0};
+}
+
+// a bundle that was merged with a bundle whose annotations dropped behind their max
+static void testMergeKeepsScoreGap() {
+    PathBundleTip bundle(1, {{ColorClasses::AnnoKey{0, 0}, initialScore()}});
+    PathBundleTip other(1, {{ColorClasses::AnnoKey{1, 0}, initialScore()}});
+    other.updateMaxScores(1);
+    other.addToScores(-30);
+    AllTips::mergeBundles(bundle, other);
+    check(!bundle.cannotBeDropped(20), "merged bundle has an annotation 30 below its max");
+}
+
+// random steps on lazy bundles give the same Score s as updating every annotation
+static void testLazyScores() {
+    std::mt19937 random(1);
+    PathBundleTip bundle;
+    Scores expected;
+    uint32_t nextTrack = 0;
+    auto addAnnotations = [&](PathBundleTip & tip, Scores & scores) {
+        size_t nAnnotations = 1 + random() % 3;
+        for (size_t i = 0; i < nAnnotations; i++) {
+            ColorClasses::AnnoKey anno{nextTrack++, 0};
+            tip.annotations[anno] = initialScore();
+            scores[anno] = initialScore();
+        }
+    };
+    addAnnotations(bundle, expected);
+    for (uint64_t step = 1; step < 2000; step++) {
+        switch (random() % 4) {
+            case 0: {
+                double delta = double(random() % 11) - 6;
+                bundle.addToScores(delta);
+                addToScores(expected, delta);
+                bundle.updateMaxScores(step);
+                updateMaxScores(expected, step);
+                break;
+            }
+            case 1: {
+                bundle.materializeScores();
+                break;
+            }
+            case 2: {
+                // a bundle of another tip with its own pending offset
+                PathBundleTip other;
+                Scores otherExpected;
+                addAnnotations(other, otherExpected);
+                size_t nSteps = random() % 5;
+                for (size_t i = 0; i < nSteps; i++) {
+                    double delta = double(random() % 11) - 6;
+                    other.addToScores(delta);
+                    addToScores(otherExpected, delta);
+                    other.updateMaxScores(step);
+                    updateMaxScores(otherExpected, step);
+                }
+                AllTips::mergeBundles(bundle, other);
+                expected.insert(otherExpected.begin(), otherExpected.end());
+                break;
+            }
+            default: {
+                checkScores(bundle, expected, "step " + std::to_string(step));
+                break;
+            }
+        }
+    }
+    checkScores(bundle, expected, "last step");
+}
+
+int main() {
+    testMergeKeepsScoreGap();
+    testLazyScores();
+    return nFailedChecks != 0;
+}
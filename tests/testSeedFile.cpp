@@ -0,0 +1,96 @@
+#include "Check.hpp"
+#include "TestGraph.hpp"
+
+#include "SeedFile.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static std::string const path = "testSeedFile.seeds";
+
+static std::vector<char> readFile(std::string const & filePath) {
+    std::ifstream inf(filePath, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(inf), std::istreambuf_iterator<char>());
+}
+
+static void writeFile(std::string const & filePath, std::vector<char> const & bytes) {
+    std::ofstream outf(filePath, std::ios::binary);
+    outf.write(bytes.data(), bytes.size());
+}
+
+static bool opens(std::string const & filePath) {
+    try {
+        SeedFile seedFile(filePath);
+        return true;
+    } catch (std::runtime_error const &) {
+        return false;
+    }
+}
+
+// corrupt changes the bytes of a valid file, which SeedFile has to reject
+static void checkRejected(std::vector<char> const & valid,
+                          std::function<void(std::vector<char> &, SeedFile::Header const &)> corrupt,
+                          std::string const & what) {
+    std::vector<char> bytes = valid;
+    SeedFile::Header header;
+    std::memcpy(&header, valid.data(), sizeof(header));
+    corrupt(bytes, header);
+    writeFile(path, bytes);
+    check(!opens(path), "a seed file with " + what + " is rejected");
+}
+
+// byte offsets of the sections, see the layout in SeedFile.hpp
+static size_t occurrenceOffsetsAt(SeedFile::Header const & header) {
+    return sizeof(SeedFile::Header) + (header.nSeeds + 1) * sizeof(uint64_t);
+}
+
+static size_t occurrencesAt(SeedFile::Header const & header) {
+    return occurrenceOffsetsAt(header) + (header.nSeeds + 1) * sizeof(uint64_t)
+           + header.nNodeIDs * sizeof(uint64_t);
+}
+
+int main() {
+    std::string genome = TestGraph::randomSequence(300, 1);
+    TestGraph testGraph({{"genome0", genome}, {"genome1", TestGraph::mutated(genome, 0.02, 2)}}, 11, 10, false);
+    testGraph.writeSeedFile(path, testGraph.seeds(17));
+    std::vector<char> valid = readFile(path);
+    check(opens(path), "a valid seed file opens");
+    {
+        SeedFile seedFile(path);
+        check(seedFile.size() > 1, "the seed file has several seeds");
+    }
+
+    checkRejected(valid, [](std::vector<char> & bytes, SeedFile::Header const &) {
+        bytes.resize(bytes.size() - 1);
+    }, "truncated names");
+    checkRejected(valid, [](std::vector<char> & bytes, SeedFile::Header const &) {
+        bytes.resize(sizeof(SeedFile::Header) + 8);
+    }, "truncated offsets");
+    checkRejected(valid, [](std::vector<char> & bytes, SeedFile::Header const &) {
+        uint64_t nSeeds = UINT64_MAX / 4;
+        std::memcpy(bytes.data() + offsetof(SeedFile::Header, nSeeds), &nSeeds, sizeof(nSeeds));
+    }, "too many seeds");
+    checkRejected(valid, [](std::vector<char> & bytes, SeedFile::Header const &) {
+        // the node IDs of seed 0 end behind the node IDs of the file
+        uint64_t offset = UINT64_MAX / 2;
+        std::memcpy(bytes.data() + sizeof(SeedFile::Header) + sizeof(uint64_t), &offset, sizeof(offset));
+    }, "an offset of the node IDs out of range");
+    checkRejected(valid, [](std::vector<char> & bytes, SeedFile::Header const & header) {
+        // seed 0 starts behind seed 1
+        uint64_t offset = 1;
+        std::memcpy(bytes.data() + occurrenceOffsetsAt(header), &offset, sizeof(offset));
+    }, "decreasing offsets of the occurrences");
+    checkRejected(valid, [](std::vector<char> & bytes, SeedFile::Header const & header) {
+        uint32_t track = header.nTracks;
+        std::memcpy(bytes.data() + occurrencesAt(header) + offsetof(SeedFile::Occurrence, track),
+                    &track, sizeof(track));
+    }, "a track index out of range");
+    return nFailedChecks != 0;
+}